@@ -14,19 +14,34 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <cutils/atomic.h>
 #include <cutils/log.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
 
 #include "Accelerometer.h"
+#include "SensorStats.h"
 
 #define EVENT_RATE_CODE_25HZ    40
 #define EVENT_RATE_CODE_50HZ    20
 #define EVENT_RATE_CODE_100HZ   10
 #define EVENT_RATE_CODE_200HZ   5
 
+#ifndef SYN_DROPPED
+#define SYN_DROPPED				3
+#endif
+
 #define G_SCALE					(GRAVITY_EARTH / 819)
-#define RATE_SYSFS_PATH			"/sys/devices/platform/s3c2440-i2c.0/i2c-0/0-0018/delay"
+#define RATE_SYSFS_PATH			SYSFS_ROOT "/sys/devices/platform/s3c2440-i2c.0/i2c-0/0-0018/delay"
+#define CALIBRATION_PATH		DATA_ROOT "/data/system/gsensor_calibration"
+#define STEP_COUNT_PATH			DATA_ROOT "/data/system/gsensor_steps"
+
+/* steps, none more than SIG_MOTION_GAP apart, that make significant motion */
+#define SIG_MOTION_STEPS		10
+#define SIG_MOTION_GAP			10000000000LL
 
 /*****************************************************************************/
 
@@ -34,8 +49,11 @@
 extern int64_t now_ns(void);
 
 Accelerometer::Accelerometer() :
-	SensorBase(NULL, NULL), mEnabled(0), mHasPendingEvent(false), mInputReader(
-			32) {
+	SensorBase(NULL, NULL), mEnabled(0), mFirstOutputs(0), mFirstTimestamp(0),
+			mStaleOutputs(0), mInputReader(32), mRate(RATE_SYSFS_PATH,
+			O_WRONLY), mDropping(false), mCalibration(CALIBRATION_PATH, G_SCALE),
+			mConsumerLag(0), mPeriod(0), mStepCounter(STEP_COUNT_PATH),
+			mMotionSteps(0), mLastMotionStep(0) {
 	data_name = "gsensor";
 	data_fd = openInput("gsensor");
 
@@ -44,18 +62,71 @@ Accelerometer::Accelerometer() :
 	mPendingEvent.type = SENSOR_TYPE_ACCELEROMETER;
 	mPendingEvent.acceleration.status = SENSOR_STATUS_ACCURACY_HIGH;
 
+	for (int i = 0; i < numOutputs; i++)
+		mDelays[i] = SENSOR_DELAY_NORMAL;
 	delay_time = -1LL;
+
+	memset(mRaw, 0, sizeof(mRaw));
+	memset(mFirst, 0, sizeof(mFirst));
+	memset(mSamples, 0, sizeof(mSamples));
+	if (mCalibration.load() == 0)
+		ALOGD("Accelerometer: using calibration from %s", CALIBRATION_PATH);
+	mStepCounter.load();
 }
 
 Accelerometer::~Accelerometer() {
-	if (data_fd >= 0)
+	mStepCounter.save();
+	if (data_fd >= 0) {
 		close( data_fd);
+		data_fd = -1;
+	}
+}
+
+/* the output column of SENSOR_LIST, for the sensors this driver serves */
+int Accelerometer::handleToOutput(int32_t handle) {
+	switch (handle) {
+#define SENSOR_OUTPUT(id, driver, output, name, vendor, type, maxRange, \
+		resolution, power, minDelay, fifoReserved, fifoMax) \
+	case ID_##id: \
+		return DRIVER_##driver == DRIVER_ACCELEROMETER ? output : -EINVAL;
+	SENSOR_LIST(SENSOR_OUTPUT)
+#undef SENSOR_OUTPUT
+	}
+	return -EINVAL;
 }
 
 int Accelerometer::setDelay(int32_t handle, int64_t ns) {
-	int sys_fd = -1;
-	unsigned int code = EVENT_RATE_CODE_25HZ;
-	char new_value[3];
+	int output = handleToOutput(handle);
+	if (output < 0)
+		return output;
+	// steps are found as well at the slowest rate, whatever is asked
+	if ((1 << output) & stepOutputs)
+		return 0;
+	mDelays[output] = ns;
+	mGovernor.reset();
+	return updateDelay();
+}
+
+/*
+ * runs the hardware at the fastest rate any enabled output asks for,
+ * unless the governor found its consumer falls behind
+ */
+int Accelerometer::updateDelay() {
+	static const unsigned int codes[] = {
+		EVENT_RATE_CODE_200HZ, EVENT_RATE_CODE_100HZ,
+		EVENT_RATE_CODE_50HZ, EVENT_RATE_CODE_25HZ,
+	};
+	const int slowest = ARRAY_SIZE(codes) - 1;
+	int rate = slowest;
+	int64_t ns = -1;
+
+	for (int i = 0; i < numOutputs; i++) {
+		if ((mEnabled & (1 << i)) && (ns < 0 || mDelays[i] < ns))
+			ns = mDelays[i];
+	}
+	if (ns < 0)
+		return 0;
+	delay_time = ns;
 
 	/*
 	 * Mapping of data rate according to the delay
@@ -69,21 +140,26 @@ int Accelerometer::setDelay(int32_t handle, int64_t ns) {
 	 * autosleep can be enabled which will reduce power consumption.
 	 */
 	if (ns <= SENSOR_DELAY_FASTEST) {
-		code = EVENT_RATE_CODE_200HZ;
+		rate = 0;
 	} else if (ns <= SENSOR_DELAY_GAME) {
-		code = EVENT_RATE_CODE_100HZ;
+		rate = 1;
 	} else if (ns <= SENSOR_DELAY_UI) {
-		code = EVENT_RATE_CODE_50HZ;
+		rate = 2;
 	}
+	// each step of the governor halves the rate, down to the slowest
+	mGovernor.setMaxThrottle(slowest - rate);
+	const unsigned int code = codes[rate + mGovernor.getThrottle()];
 
-	/* Change data rate through sysfs entry */
-	sys_fd = open(RATE_SYSFS_PATH, O_WRONLY);
-	if (sys_fd < 0)
-		return 0;
+	// the rate codes are the sampling period in milliseconds
+	const int64_t period = code * 1000000LL;
+	mPeriod = period;
+	for (int i = 0; i < numOutputs; i++)
+		mDecimators[i].setFactor(mDelays[i] / period);
+	mTimestampFilter.setPeriod(period);
+	mStepDetector.setPeriod(period);
 
-	sprintf(new_value, "%d", code);
-	write(sys_fd, new_value, sizeof(new_value));
-	close(sys_fd);
+	/* Change data rate through sysfs entry, unless it already runs at it */
+	mRate.write(code);
 
 	return 0;
 }
@@ -93,70 +169,378 @@ int64_t Accelerometer::getDelay() const {
 }
 
 int Accelerometer::enable(int32_t handle, int en) {
-	if ((en != 0) && (data_fd >= 0)) {
-		mEnabled = true;
-	} else
-		mEnabled = false;
-	return 0;
+	int output = handleToOutput(handle);
+	if (output < 0)
+		return output;
+
+	uint32_t virtuals = mEnabled & filterOutputs;
+	uint32_t steps = mEnabled & stepOutputs;
+	// remember the request even without a device, it may show up later
+	if (en != 0) {
+		/*
+		 * Rather than wait up to a whole sampling period, or for the
+		 * part to wake from autosleep, serve the axes as they stand now:
+		 * the reader thread finds the event pending on its next pass.
+		 */
+		if (!(mEnabled & (1 << output)) && !((1 << output) & stepOutputs)
+				&& readAxes(mFirst) == 0) {
+			mFirstTimestamp = getTimestamp();
+			android_atomic_or(1 << output, &mFirstOutputs);
+		}
+		// significant motion is one-shot, re-armed by each enable
+		if (output == significantMotion)
+			mMotionSteps = 0;
+		mEnabled |= 1 << output;
+	} else {
+		mEnabled &= ~(1 << output);
+		if (output == stepCounter)
+			mStepCounter.save();
+	}
+	mGovernor.reset();
+
+	// start the filters afresh when the first sensor they serve comes up
+	if (!virtuals && (mEnabled & filterOutputs))
+		mGravityFilter.reset();
+	if (!steps && (mEnabled & stepOutputs))
+		mStepDetector.reset();
+	return updateDelay();
 }
 
 bool Accelerometer::hasPendingEvents() const {
-	return false;
+	// samples left behind by a read that ran out of room count as well
+	return android_atomic_acquire_load(&mFirstOutputs) != 0
+			|| mInputReader.getCount() != 0;
+}
+
+/*
+ * Delivers the sample enable() read to the outputs it was read for,
+ * as is: there is nothing to decimate yet.
+ */
+int Accelerometer::emitFirst(sensors_event_t* data, int count) {
+	uint32_t outputs = android_atomic_and(0, &mFirstOutputs) & mEnabled;
+	if (__builtin_popcount(outputs) > count) {
+		// no room this time round, keep it for the next read
+		android_atomic_or(outputs, &mFirstOutputs);
+		return 0;
+	}
+
+	const int64_t timestamp = mFirstTimestamp;
+	float* sample = mSamples[0];
+	sample[0] = mFirst[0];
+	sample[1] = mFirst[1];
+	sample[2] = mFirst[2];
+	mCalibration.apply(sample, 1);
+	mPendingEvent.acceleration.x = sample[0];
+	mPendingEvent.acceleration.y = sample[1];
+	mPendingEvent.acceleration.z = sample[2];
+	mPendingEvent.timestamp = timestamp;
+	// samples the ring still holds from before would go back in time
+	mStaleOutputs = outputs;
+
+	// a filter already running for other outputs has a better estimate
+	uint32_t virtuals = outputs & filterOutputs;
+	if (virtuals && !(mEnabled & ~outputs & filterOutputs))
+		mGravityFilter.update(sample, timestamp);
+
+	int nb = 0;
+	if (outputs & (1 << accel))
+		emitVector(&data[nb++], ID_A, SENSOR_TYPE_ACCELEROMETER, sample,
+				timestamp);
+	if (outputs & (1 << gravity))
+		emitVector(&data[nb++], ID_G, SENSOR_TYPE_GRAVITY,
+				mGravityFilter.getGravity(), timestamp);
+	if (outputs & (1 << linear))
+		emitVector(&data[nb++], ID_LA, SENSOR_TYPE_LINEAR_ACCELERATION,
+				mGravityFilter.getLinearAcceleration(), timestamp);
+	if (outputs & (1 << orientation))
+		emitOrientation(&data[nb++], timestamp);
+	return nb;
 }
 
 int Accelerometer::readEvents(sensors_event_t* data, int count) {
 	if (count < 1)
 		return -EINVAL;
 
-	ssize_t n = mInputReader.fill(data_fd);
+	// the first sample goes out on its own rather than wait on the fd,
+	// the fd stays readable for the next round of the reader thread
+	if (android_atomic_acquire_load(&mFirstOutputs))
+		return emitFirst(data, count);
+
+	int numEventReceived = 0;
+
+	// samples left in the ring go out first, the fd is only read once
+	// they are all gone so that a blocking one could never hold them up
+	ssize_t n = mInputReader.getCount() ? 0 : mInputReader.fill(data_fd);
+	if (n == -ENODEV) {
+		// unplugged, hotplug() reopens it once it is back
+		ALOGE("Accelerometer: %s went away", input_name);
+		close(data_fd);
+		data_fd = -1;
+		// or hasPendingEvents() would keep the reader thread spinning
+		mInputReader.reset();
+	}
 	if (n < 0)
 		return n;
 
-	int numEventReceived = 0;
-	input_event const* event;
-
-	while (count && mInputReader.readEvent(&event)) {
-		int type = event->type;
-		if (type == EV_ABS) {
-			processEvent(event->code, event->value);
-		} else if (type == EV_SYN) {
-			int64_t time = timevalToNano(event->time);
-			mPendingEvent.timestamp = time;
-			if (mEnabled) {
-				*data++ = mPendingEvent;
-				count--;
-				numEventReceived++;
-				// FOR DEBUG
-				/* ALOGE("Accelerometer: x = %f, y = %f, z = %f",
-						mPendingEvent.acceleration.x,
-						mPendingEvent.acceleration.y,
-						mPendingEvent.acceleration.z);
-				*/
+	// a sample turns into at most one event per enabled output, but for
+	// the step detector which may report the step which opened a walk
+	int outputs = __builtin_popcount(mEnabled)
+			+ ((mEnabled & (1 << stepDetector)) ? 1 : 0);
+	int room = (count - numEventReceived) / (outputs ? outputs : 1);
+	if (room > maxSamples)
+		room = maxSamples;
+
+	int numSamples = 0;
+	input_event const* events;
+	ssize_t available;
+	const int64_t clockOffset = input_realtime ? getRealtimeOffset() : 0;
+
+	// decode whole spans of the ring at a time, leaving the samples
+	// that don't fit in it
+	while (numSamples < room && (available = mInputReader.readEvents(
+			&events)) > 0) {
+		ssize_t i;
+		for (i = 0; numSamples < room && i < available; i++) {
+			input_event const* event = &events[i];
+			int type = event->type;
+			if (mDropping) {
+				// what is left of the lost sample, up to the next report
+				if (type == EV_SYN && event->code == SYN_REPORT)
+					resync();
+			} else if (type == EV_ABS) {
+				processEvent(event->code, event->value);
+			} else if (type == EV_SYN && event->code == SYN_DROPPED) {
+				ALOGW("Accelerometer: %s overran, resyncing", input_name);
+				mDropping = true;
+				if (stats)
+					stats->recordOverrun(ID_A, 1);
+			} else if (type == EV_SYN && event->code == SYN_REPORT) {
+				float* sample = mSamples[numSamples];
+				sample[0] = mRaw[0];
+				sample[1] = mRaw[1];
+				sample[2] = mRaw[2];
+				mTimestamps[numSamples++] = mTimestampFilter.filter(
+						timevalToNano(event->time) - clockOffset);
+			} else if (type != EV_SYN) {
+				ALOGE("Accelerometer: unknown event (type=%d, code=%d)", type,
+						event->code);
 			}
-		} else {
-			ALOGE("Accelerometer: unknown event (type=%d, code=%d)", type,
-					event->code);
 		}
-		mInputReader.next();
+		mInputReader.consume(i);
+	}
+
+	if (numSamples && mGovernor.update(mConsumerLag, mPeriod,
+			getTimestamp())) {
+		ALOGD("Accelerometer: consumer lags, rate at 1/%d of the requested one",
+				1 << mGovernor.getThrottle());
+		updateDelay();
+	}
+
+	// raw counts to calibrated m/s^2, the whole batch at once
+	mCalibration.apply(mSamples[0], numSamples);
+
+	for (int i = 0; i < numSamples; i++) {
+		float const* sample = mSamples[i];
+		uint32_t outputs = mEnabled;
+		if (mStaleOutputs) {
+			if (mTimestamps[i] <= mFirstTimestamp)
+				outputs &= ~mStaleOutputs;
+			else
+				mStaleOutputs = 0;
+		}
+		mPendingEvent.acceleration.x = sample[0];
+		mPendingEvent.acceleration.y = sample[1];
+		mPendingEvent.acceleration.z = sample[2];
+		mPendingEvent.timestamp = mTimestamps[i];
+		if (mBiasEstimator.update(sample, mTimestamps[i]))
+			updateBias();
+		numEventReceived += emitEvents(data + numEventReceived, outputs);
 	}
 	return numEventReceived;
 }
 
+/*
+ * After an overrun the axes may have changed in events that were lost:
+ * read their current values back rather than trust the partial update.
+ */
+void Accelerometer::resync() {
+	mDropping = false;
+	readAxes(mRaw);
+}
+
+/* reads the current raw value of each axis, leaving those it fails on */
+int Accelerometer::readAxes(float* raw) const {
+	static const int axes[3] = { ABS_X, ABS_Y, ABS_Z };
+	struct input_absinfo info;
+	int err = 0;
+
+	if (data_fd < 0)
+		return -ENODEV;
+	for (int i = 0; i < 3; i++) {
+		if (ioctl(data_fd, EVIOCGABS(axes[i]), &info) == 0)
+			raw[i] = info.value;
+		else
+			err = -errno;
+	}
+	return err;
+}
+
+/* folds the residual bias the estimator found into the calibration */
+void Accelerometer::updateBias() {
+	float const* residual = mBiasEstimator.getBias();
+	float const* current = mCalibration.getBias();
+	float bias[3];
+
+	for (int i = 0; i < 3; i++)
+		bias[i] = current[i] + residual[i];
+	ALOGD("Accelerometer: bias now %f %f %f", bias[0], bias[1], bias[2]);
+	mCalibration.setBias(bias);
+	mCalibration.save();
+	// the resting samples it kept are off by the old bias
+	mBiasEstimator.reset();
+}
+
+/*
+ * turns the sample in mPendingEvent into an event per enabled output
+ * whose decimation group is complete
+ */
+int Accelerometer::emitEvents(sensors_event_t* data, uint32_t outputs) {
+	const int64_t timestamp = mPendingEvent.timestamp;
+	int nb = 0;
+
+	if ((outputs & (1 << accel)) && mDecimators[accel].update(
+			mPendingEvent.acceleration.v, timestamp))
+		emitVector(&data[nb++], ID_A, SENSOR_TYPE_ACCELEROMETER,
+				mDecimators[accel].getOutput(),
+				mDecimators[accel].getTimestamp());
+	if (outputs & stepOutputs)
+		nb += emitSteps(&data[nb], outputs);
+	if (!(outputs & filterOutputs))
+		return nb;
+
+	// the filter sees every sample, whatever rate its outputs run at
+	mGravityFilter.update(mPendingEvent.acceleration.v, timestamp);
+
+	if ((outputs & (1 << gravity)) && mDecimators[gravity].update(
+			mGravityFilter.getGravity(), timestamp))
+		emitVector(&data[nb++], ID_G, SENSOR_TYPE_GRAVITY,
+				mDecimators[gravity].getOutput(),
+				mDecimators[gravity].getTimestamp());
+	if ((outputs & (1 << linear)) && mDecimators[linear].update(
+			mGravityFilter.getLinearAcceleration(), timestamp))
+		emitVector(&data[nb++], ID_LA, SENSOR_TYPE_LINEAR_ACCELERATION,
+				mDecimators[linear].getOutput(),
+				mDecimators[linear].getTimestamp());
+	// already low-passed through the gravity estimate
+	if ((outputs & (1 << orientation)) && mDecimators[orientation].tick(
+			timestamp))
+		emitOrientation(&data[nb++], mDecimators[orientation].getTimestamp());
+	return nb;
+}
+
+/* runs the step detector on the sample in mPendingEvent */
+int Accelerometer::emitSteps(sensors_event_t* data, uint32_t outputs) {
+	int steps = mStepDetector.update(mPendingEvent.acceleration.v,
+			mPendingEvent.timestamp);
+	if (!steps)
+		return 0;
+
+	int nb = 0;
+	if (outputs & (1 << stepDetector)) {
+		for (int i = 0; i < steps; i++)
+			emitTrigger(&data[nb++], ID_SD, SENSOR_TYPE_STEP_DETECTOR,
+					mStepDetector.getStepTimestamp(i));
+	}
+	const int64_t timestamp = mStepDetector.getStepTimestamp(steps - 1);
+	if (outputs & (1 << stepCounter)) {
+		sensors_event_t* ev = &data[nb++];
+		emitTrigger(ev, ID_SC, SENSOR_TYPE_STEP_COUNTER, timestamp);
+		ev->u64.step_counter = mStepCounter.add(steps);
+	}
+	if (outputs & (1 << significantMotion)) {
+		if (mMotionSteps && timestamp - mLastMotionStep > SIG_MOTION_GAP)
+			mMotionSteps = 0;
+		mMotionSteps += steps;
+		mLastMotionStep = timestamp;
+		if (mMotionSteps >= SIG_MOTION_STEPS) {
+			emitTrigger(&data[nb++], ID_SM, SENSOR_TYPE_SIGNIFICANT_MOTION,
+					timestamp);
+			// one-shot: off until enabled again, the context then lets
+			// go of the driver if nothing else uses it
+			mEnabled &= ~(1 << significantMotion);
+			updateDelay();
+		}
+	}
+	return nb;
+}
+
+/* an event whose only value is 1, or the step count set by the caller */
+void Accelerometer::emitTrigger(sensors_event_t* ev, int32_t sensor,
+		int32_t type, int64_t timestamp) {
+	memset(ev, 0, sizeof(*ev));
+	ev->version = sizeof(sensors_event_t);
+	ev->sensor = sensor;
+	ev->type = type;
+	ev->timestamp = timestamp;
+	ev->data[0] = 1.0f;
+}
+
+void Accelerometer::emitOrientation(sensors_event_t* ev, int64_t timestamp) {
+	*ev = mPendingEvent;
+	ev->sensor = ID_O;
+	ev->type = SENSOR_TYPE_ORIENTATION;
+	ev->timestamp = timestamp;
+	// there is no magnetometer to tell the heading from
+	ev->orientation.azimuth = 0;
+	mGravityFilter.getOrientation(&ev->orientation.pitch,
+			&ev->orientation.roll);
+	ev->orientation.status = SENSOR_STATUS_ACCURACY_LOW;
+}
+
+void Accelerometer::emitVector(sensors_event_t* ev, int32_t sensor,
+		int32_t type, float const* v, int64_t timestamp) {
+	*ev = mPendingEvent;
+	ev->sensor = sensor;
+	ev->type = type;
+	ev->timestamp = timestamp;
+	ev->acceleration.x = v[0];
+	ev->acceleration.y = v[1];
+	ev->acceleration.z = v[2];
+}
+
+void Accelerometer::setConsumerLag(int64_t lag) {
+	mConsumerLag = lag;
+}
+
 void Accelerometer::processEvent(int code, int value) {
 	switch (code) {
 	case ABS_X:
-		mPendingEvent.acceleration.x = value * G_SCALE;
+		mRaw[0] = value;
 		break;
 	case ABS_Y:
-		mPendingEvent.acceleration.y = value * G_SCALE;
+		mRaw[1] = value;
 		break;
 	case ABS_Z:
-		mPendingEvent.acceleration.z = value * G_SCALE;
+		mRaw[2] = value;
 		break;
 	}
 }
 
 int Accelerometer::getFd() const {
-	ALOGE("Accelerometer: getFd returning %d", data_fd);
+	ALOGV("Accelerometer: getFd returning %d", data_fd);
 	return data_fd;
 }
+
+int Accelerometer::hotplug() {
+	if (data_fd >= 0)
+		return 0;
+	data_fd = openInput(data_name);
+	if (data_fd < 0)
+		return 0;
+	ALOGD("Accelerometer: found %s on %s", data_name, input_name);
+	// restore the rate the hardware lost while it was gone
+	mRate.close();
+	mTimestampFilter.reset();
+	updateDelay();
+	return 1;
+}
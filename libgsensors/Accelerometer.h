@@ -20,6 +20,14 @@
 #include "sensors.h"
 #include "SensorBase.h"
 #include "InputEventReader.h"
+#include "GravityFilter.h"
+#include "Decimator.h"
+#include "Calibration.h"
+#include "BiasEstimator.h"
+#include "TimestampFilter.h"
+#include "RateGovernor.h"
+#include "StepDetector.h"
+#include "StepCounter.h"
 
 #define SENSOR_DELAY_FASTEST   1000000LL
 #define SENSOR_DELAY_GAME      20000000LL
@@ -30,11 +38,81 @@
 
 struct input_event;
 
+/*
+ * Besides the raw accelerometer this driver serves the gravity, linear
+ * acceleration and orientation virtual sensors, which are derived from
+ * the same samples through a single GravityFilter, and the step detector,
+ * step counter and significant motion sensors, which follow a single
+ * StepDetector. The hardware runs at the fastest rate any output asked
+ * for and each output is decimated down to its own.
+ */
 class Accelerometer : public SensorBase {
-	int mEnabled;
+	enum {
+		accel = 0,
+		gravity,
+		linear,
+		orientation,
+		stepDetector,
+		stepCounter,
+		significantMotion,
+		numOutputs,
+	};
+
+	enum {
+		// outputs derived through the gravity filter
+		filterOutputs = (1 << gravity) | (1 << linear) | (1 << orientation),
+		// outputs derived from the steps, which run at the slowest rate
+		stepOutputs = (1 << stepDetector) | (1 << stepCounter)
+				| (1 << significantMotion),
+	};
+
+	enum {
+		// samples decoded and calibrated together
+		maxSamples = 32,
+	};
+
+	uint32_t mEnabled;
+	int64_t mDelays[numOutputs];
 	sensors_event_t mPendingEvent;
-	bool mHasPendingEvent;
+	// outputs owed the sample read on enable, and that sample
+	volatile int32_t mFirstOutputs;
+	float mFirst[3];
+	int64_t mFirstTimestamp;
+	// outputs already served a sample up to mFirstTimestamp
+	uint32_t mStaleOutputs;
 	InputEventCircularReader mInputReader;
+	GravityFilter mGravityFilter;
+	Decimator mDecimators[numOutputs];
+	SysfsAttribute mRate;
+	float mRaw[3];
+	bool mDropping;
+	float mSamples[maxSamples][4] __attribute__((aligned(16)));
+	int64_t mTimestamps[maxSamples];
+	Calibration mCalibration;
+	BiasEstimator mBiasEstimator;
+	TimestampFilter mTimestampFilter;
+	RateGovernor mGovernor;
+	int64_t mConsumerLag;
+	int64_t mPeriod;
+	StepDetector mStepDetector;
+	StepCounter mStepCounter;
+	// steps towards significant motion and when the last was taken
+	int mMotionSteps;
+	int64_t mLastMotionStep;
+
+	static int handleToOutput(int32_t handle);
+	int updateDelay();
+	int emitEvents(sensors_event_t* data, uint32_t outputs);
+	int emitFirst(sensors_event_t* data, int count);
+	int emitSteps(sensors_event_t* data, uint32_t outputs);
+	void updateBias();
+	int readAxes(float* raw) const;
+	void resync();
+	void emitVector(sensors_event_t* ev, int32_t sensor, int32_t type,
+			float const* v, int64_t timestamp);
+	void emitOrientation(sensors_event_t* ev, int64_t timestamp);
+	void emitTrigger(sensors_event_t* ev, int32_t sensor, int32_t type,
+			int64_t timestamp);
 
 public:
 	Accelerometer();
@@ -46,6 +124,8 @@ public:
 	virtual int getFd() const;
 	virtual int64_t getDelay() const;
 	virtual int setDelay(int32_t handle, int64_t ns);
+	virtual int hotplug();
+	virtual void setConsumerLag(int64_t lag);
 	void processEvent(int code, int value);
 };
 
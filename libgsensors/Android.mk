@@ -15,17 +15,39 @@
 
 LOCAL_PATH:= $(call my-dir)
 
-include $(CLEAR_VARS)
-
-LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
-LOCAL_SRC_FILES :=                     \
+sensors_src_files :=                   \
                 InputEventReader.cpp   \
                 SensorBase.cpp         \
+                SysfsAttribute.cpp     \
                 sensors.cpp            \
                 LightSensor.cpp        \
                 ProximitySensor.cpp    \
                 Accelerometer.cpp      \
-                TemperatureMonitor.cpp
+                TemperatureMonitor.cpp \
+                SensorFifo.cpp         \
+                PackedSensorFifo.cpp   \
+                SensorEventQueue.cpp   \
+                SensorThread.cpp       \
+                SensorReactor.cpp      \
+                GravityFilter.cpp      \
+                Decimator.cpp          \
+                Calibration.cpp        \
+                BiasEstimator.cpp      \
+                TimestampFilter.cpp    \
+                SensorStats.cpp        \
+                InputDeviceIndex.cpp   \
+                IioBuffer.cpp          \
+                ChangeFilter.cpp       \
+                RateGovernor.cpp       \
+                StepDetector.cpp       \
+                StepCounter.cpp        \
+                DirectChannel.cpp      \
+                AtomicFile.cpp
+
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
+LOCAL_SRC_FILES := $(sensors_src_files)
 
 LOCAL_C_INCLUDES += $(LOCAL_PATH)
 
@@ -40,3 +62,27 @@ LOCAL_MODULE_TAGS := eng
 LOCAL_MODULE := sensors.$(TARGET_DEVICE)
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Replay benchmark of the HAL on the build host, see bench/sensors_bench.cpp:
+#   make sensors_bench && sensors_bench -m hal -r 200
+# Outside an AOSP tree, bench/Makefile builds it against stub headers.
+# Keep its source list in step with sensors_src_files.
+ifeq ($(HOST_OS),linux)
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\" -DSYSFS_ROOT=\"/tmp/gsensors-bench\" \
+	-DDATA_ROOT=\"/tmp/gsensors-bench\"
+LOCAL_SRC_FILES := $(sensors_src_files) bench/sensors_bench.cpp
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)
+
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_CPPFLAGS += -DLINUX=1
+LOCAL_LDLIBS := -lpthread -lrt -lm
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_MODULE := sensors_bench
+
+include $(BUILD_HOST_EXECUTABLE)
+endif
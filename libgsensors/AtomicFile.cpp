@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <cutils/log.h>
+
+#include "AtomicFile.h"
+
+/*****************************************************************************/
+
+int writeFileAtomic(const char* path, const char* contents) {
+	char tmp[PATH_MAX];
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	FILE* f = fopen(tmp, "w");
+	if (!f) {
+		ALOGE("couldn't write %s (%s)", tmp, strerror(errno));
+		return -errno;
+	}
+	bool written = fputs(contents, f) >= 0 && fflush(f) == 0
+			&& fsync(fileno(f)) == 0;
+	if (fclose(f) != 0 || !written || rename(tmp, path) < 0) {
+		int err = errno;
+		ALOGE("couldn't update %s (%s)", path, strerror(err));
+		unlink(tmp);
+		return -err;
+	}
+	return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_ATOMIC_FILE_H
+#define ANDROID_ATOMIC_FILE_H
+
+#include <sys/cdefs.h>
+
+/*****************************************************************************/
+
+/*
+ * Replaces the file at path with contents. They are written to path.tmp
+ * and synced before it is renamed over path, so that a crash leaves
+ * either the old file or the new one, never half of it.
+ */
+int writeFileAtomic(const char* path, const char* contents);
+
+/*****************************************************************************/
+
+#endif  // ANDROID_ATOMIC_FILE_H
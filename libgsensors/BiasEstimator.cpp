@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <math.h>
+#include <string.h>
+#include <hardware/sensors.h>
+
+#include "BiasEstimator.h"
+
+/*****************************************************************************/
+
+/* how long the device has to rest for a sample to be taken, in ns */
+#define STATIONARY_WINDOW		1000000000LL
+#define MIN_WINDOW_SAMPLES		10
+/* per axis variance below which the device is at rest, in (m/s^2)^2 */
+#define STATIONARY_VARIANCE		(0.05f * 0.05f)
+/* resting samples further than this from 1g are not to be trusted */
+#define MAX_GRAVITY_ERROR		1.5f
+/* estimates beyond this are rejected, below the other ignored */
+#define MAX_BIAS				1.5f
+#define MIN_BIAS				0.02f
+
+BiasEstimator::BiasEstimator() {
+	reset();
+}
+
+void BiasEstimator::reset() {
+	memset(mSum, 0, sizeof(mSum));
+	memset(mSumSq, 0, sizeof(mSumSq));
+	mCount = 0;
+	mWindowStart = 0;
+	mFilled = 0;
+	memset(mBias, 0, sizeof(mBias));
+}
+
+bool BiasEstimator::update(float const* v, int64_t timestamp) {
+	if (mCount == 0)
+		mWindowStart = timestamp;
+	for (int i = 0; i < 3; i++) {
+		mSum[i] += v[i];
+		mSumSq[i] += v[i] * v[i];
+	}
+	mCount++;
+	if (timestamp - mWindowStart < STATIONARY_WINDOW)
+		return false;
+
+	bool stationary = mCount >= MIN_WINDOW_SAMPLES;
+	float mean[3];
+	for (int i = 0; i < 3; i++) {
+		mean[i] = mSum[i] / mCount;
+		float variance = mSumSq[i] / mCount - mean[i] * mean[i];
+		if (variance > STATIONARY_VARIANCE)
+			stationary = false;
+	}
+	memset(mSum, 0, sizeof(mSum));
+	memset(mSumSq, 0, sizeof(mSumSq));
+	mCount = 0;
+
+	if (!stationary)
+		return false;
+	float norm = sqrtf(mean[0] * mean[0] + mean[1] * mean[1] + mean[2]
+			* mean[2]);
+	if (fabsf(norm - GRAVITY_EARTH) > MAX_GRAVITY_ERROR)
+		return false;
+
+	addPoint(mean);
+	if (__builtin_popcount(mFilled) < MIN_DIRECTIONS)
+		return false;
+	// with an axis never pointing down its bias is not observable
+	for (int axis = 0; axis < 3; axis++) {
+		if (!(mFilled & (3 << (axis * 2))))
+			return false;
+	}
+
+	float bias[3];
+	if (!solve(bias))
+		return false;
+	float size = sqrtf(bias[0] * bias[0] + bias[1] * bias[1] + bias[2]
+			* bias[2]);
+	if (size > MAX_BIAS || size < MIN_BIAS)
+		return false;
+	memcpy(mBias, bias, sizeof(mBias));
+	return true;
+}
+
+/* keeps the latest resting sample per face of the device facing down */
+void BiasEstimator::addPoint(float const* mean) {
+	int axis = 0;
+	for (int i = 1; i < 3; i++) {
+		if (fabsf(mean[i]) > fabsf(mean[axis]))
+			axis = i;
+	}
+	int direction = axis * 2 + (mean[axis] < 0);
+	memcpy(mPoints[direction], mean, sizeof(mPoints[direction]));
+	mFilled |= 1 << direction;
+}
+
+/*
+ * |a - b|^2 = g^2 is linear in b and k = |b|^2:
+ *   2 a.b - k = |a|^2 - g^2
+ * solved in the least squares sense through its normal equations.
+ */
+bool BiasEstimator::solve(float* bias) const {
+	double m[4][5];
+
+	memset(m, 0, sizeof(m));
+	for (int d = 0; d < NUM_DIRECTIONS; d++) {
+		if (!(mFilled & (1 << d)))
+			continue;
+		float const* a = mPoints[d];
+		double row[5] = { 2 * a[0], 2 * a[1], 2 * a[2], -1, a[0] * a[0] + a[1]
+				* a[1] + a[2] * a[2] - GRAVITY_EARTH * GRAVITY_EARTH };
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 5; j++)
+				m[i][j] += row[i] * row[j];
+		}
+	}
+
+	// Gaussian elimination with partial pivoting
+	for (int c = 0; c < 4; c++) {
+		int pivot = c;
+		for (int r = c + 1; r < 4; r++) {
+			if (fabs(m[r][c]) > fabs(m[pivot][c]))
+				pivot = r;
+		}
+		// the resting samples do not span all three axes yet
+		if (fabs(m[pivot][c]) < 1e-6)
+			return false;
+		if (pivot != c) {
+			for (int j = 0; j < 5; j++) {
+				double t = m[c][j];
+				m[c][j] = m[pivot][j];
+				m[pivot][j] = t;
+			}
+		}
+		for (int r = 0; r < 4; r++) {
+			if (r == c)
+				continue;
+			double f = m[r][c] / m[c][c];
+			for (int j = c; j < 5; j++)
+				m[r][j] -= f * m[c][j];
+		}
+	}
+	for (int i = 0; i < 3; i++)
+		bias[i] = m[i][4] / m[i][i];
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_BIAS_ESTIMATOR_H
+#define ANDROID_BIAS_ESTIMATOR_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Online estimate of the accelerometer bias. Whenever the device rests
+ * for a while the mean sample is kept, one per rough orientation, and
+ * once they span all three axes the sphere |sample - bias| = g is fitted
+ * through them. Fed calibrated samples, it yields the residual bias.
+ */
+class BiasEstimator {
+	enum {
+		NUM_DIRECTIONS = 6,
+		MIN_DIRECTIONS = 4,
+	};
+
+	float mSum[3];
+	float mSumSq[3];
+	int mCount;
+	int64_t mWindowStart;
+	float mPoints[NUM_DIRECTIONS][3];
+	uint32_t mFilled;
+	float mBias[3];
+
+	void addPoint(float const* mean);
+	bool solve(float* bias) const;
+
+public:
+	BiasEstimator();
+
+	void reset();
+	/* returns true when a new bias estimate worth applying is available */
+	bool update(float const* v, int64_t timestamp);
+	float const* getBias() const { return mBias; }
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_BIAS_ESTIMATOR_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <cutils/log.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "AtomicFile.h"
+#include "Calibration.h"
+
+/*****************************************************************************/
+
+Calibration::Calibration(const char* path, float scale) :
+	mPath(path), mScale(scale) {
+	memset(mMatrix, 0, sizeof(mMatrix));
+	mMatrix[0] = mMatrix[4] = mMatrix[8] = 1.0f;
+	memset(mBias, 0, sizeof(mBias));
+	update();
+}
+
+void Calibration::update() {
+	for (int c = 0; c < 3; c++) {
+		for (int r = 0; r < 3; r++)
+			mColumns[c][r] = mMatrix[r * 3 + c] * mScale;
+		mColumns[c][3] = 0;
+	}
+	for (int r = 0; r < 3; r++)
+		mOffset[r] = -mBias[r];
+	mOffset[3] = 0;
+}
+
+int Calibration::load() {
+	float v[12];
+
+	FILE* f = fopen(mPath, "r");
+	if (!f)
+		return -errno;
+	int n = fscanf(f, "%f %f %f %f %f %f %f %f %f %f %f %f", &v[0], &v[1],
+			&v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10],
+			&v[11]);
+	fclose(f);
+	if (n != 12) {
+		ALOGE("Calibration: %s is malformed, ignoring it", mPath);
+		return -EINVAL;
+	}
+	memcpy(mMatrix, v, sizeof(mMatrix));
+	memcpy(mBias, v + 9, sizeof(mBias));
+	update();
+	return 0;
+}
+
+int Calibration::save() const {
+	char contents[512];
+
+	const float* m = mMatrix;
+	snprintf(contents, sizeof(contents),
+			"%f %f %f\n%f %f %f\n%f %f %f\n%f %f %f\n", m[0], m[1], m[2],
+			m[3], m[4], m[5], m[6], m[7], m[8], mBias[0], mBias[1], mBias[2]);
+	return writeFileAtomic(mPath, contents);
+}
+
+void Calibration::setBias(float const* bias) {
+	memcpy(mBias, bias, sizeof(mBias));
+	update();
+}
+
+void Calibration::apply(float* samples, size_t count) const {
+#if defined(__ARM_NEON__)
+	const float32x4_t c0 = vld1q_f32(mColumns[0]);
+	const float32x4_t c1 = vld1q_f32(mColumns[1]);
+	const float32x4_t c2 = vld1q_f32(mColumns[2]);
+	const float32x4_t offset = vld1q_f32(mOffset);
+	for (size_t i = 0; i < count; i++, samples += 4) {
+		float32x4_t raw = vld1q_f32(samples);
+		float32x4_t out = vmlaq_lane_f32(offset, c0, vget_low_f32(raw), 0);
+		out = vmlaq_lane_f32(out, c1, vget_low_f32(raw), 1);
+		out = vmlaq_lane_f32(out, c2, vget_high_f32(raw), 0);
+		vst1q_f32(samples, out);
+	}
+#elif defined(__SSE__)
+	// unaligned: operator new only promises 8 bytes on 32-bit x86, so
+	// the attributes of a heap allocated driver are not enough
+	const __m128 c0 = _mm_loadu_ps(mColumns[0]);
+	const __m128 c1 = _mm_loadu_ps(mColumns[1]);
+	const __m128 c2 = _mm_loadu_ps(mColumns[2]);
+	const __m128 offset = _mm_loadu_ps(mOffset);
+	for (size_t i = 0; i < count; i++, samples += 4) {
+		__m128 raw = _mm_loadu_ps(samples);
+		__m128 out = _mm_add_ps(offset, _mm_mul_ps(c0, _mm_shuffle_ps(raw,
+				raw, _MM_SHUFFLE(0, 0, 0, 0))));
+		out = _mm_add_ps(out, _mm_mul_ps(c1, _mm_shuffle_ps(raw, raw,
+				_MM_SHUFFLE(1, 1, 1, 1))));
+		out = _mm_add_ps(out, _mm_mul_ps(c2, _mm_shuffle_ps(raw, raw,
+				_MM_SHUFFLE(2, 2, 2, 2))));
+		_mm_storeu_ps(samples, out);
+	}
+#else
+	for (size_t i = 0; i < count; i++, samples += 4) {
+		const float x = samples[0], y = samples[1], z = samples[2];
+		for (int r = 0; r < 3; r++)
+			samples[r] = mColumns[0][r] * x + mColumns[1][r] * y
+					+ mColumns[2][r] * z + mOffset[r];
+	}
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_CALIBRATION_H
+#define ANDROID_CALIBRATION_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Per device correction of raw accelerometer samples:
+ *   out = M * (scale * raw) - bias
+ * M fixes the axis misalignment and gain, bias is in the output frame.
+ * The file holds the nine entries of M row by row followed by the bias,
+ * whitespace separated; without one M is the identity and bias zero.
+ */
+class Calibration {
+	const char* const mPath;
+	const float mScale;
+	float mMatrix[9];
+	float mBias[3];
+	// scale * M by column and -bias, four wide for the SIMD kernel
+	float mColumns[3][4] __attribute__((aligned(16)));
+	float mOffset[4] __attribute__((aligned(16)));
+
+	void update();
+
+public:
+	Calibration(const char* path, float scale);
+
+	int load();
+	int save() const;
+
+	/* converts count samples of four floats (x, y, z, unused) in place */
+	void apply(float* samples, size_t count) const;
+
+	float const* getBias() const { return mBias; }
+	void setBias(float const* bias);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_CALIBRATION_H
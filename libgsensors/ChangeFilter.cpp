@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <cutils/log.h>
+#include <cutils/properties.h>
+
+#include "ChangeFilter.h"
+
+/*****************************************************************************/
+
+ChangeFilter::ChangeFilter(const char* property, float absolute,
+		float relative, int64_t minInterval) :
+	mAbsolute(absolute), mRelative(relative), mMinInterval(minInterval) {
+	char value[PROPERTY_VALUE_MAX];
+	float a, r;
+	int ms;
+
+	if (property && property_get(property, value, NULL) > 0) {
+		if (sscanf(value, "%f %f %d", &a, &r, &ms) == 3 && a >= 0 && r >= 0
+				&& ms >= 0) {
+			mAbsolute = a;
+			mRelative = r;
+			mMinInterval = ms * 1000000LL;
+		} else {
+			ALOGE("ChangeFilter: ignoring malformed %s '%s'", property, value);
+		}
+	}
+	reset();
+}
+
+void ChangeFilter::reset() {
+	mLastValue = 0;
+	mLastTime = 0;
+	mHasValue = false;
+}
+
+bool ChangeFilter::update(float value, int64_t timestamp) {
+	if (mHasValue) {
+		float threshold = mRelative * fabsf(mLastValue);
+		if (threshold < mAbsolute)
+			threshold = mAbsolute;
+		if (!(fabsf(value - mLastValue) > threshold))
+			return false;
+		if (timestamp - mLastTime < mMinInterval)
+			return false;
+	}
+	mLastValue = value;
+	mLastTime = timestamp;
+	mHasValue = true;
+	return true;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_CHANGE_FILTER_H
+#define ANDROID_CHANGE_FILTER_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Reporting policy of an on-change sensor. A value is only reported when
+ * it moved away from the last reported one by more than the absolute or
+ * relative threshold, whichever is larger, and no sooner than the minimum
+ * interval after it. Since the band is centred on the reported value and
+ * not on the last sample, noise within it never produces an event.
+ *
+ * The defaults can be overridden by a property holding
+ * "<absolute> <relative> <interval in ms>", e.g. "1 0.1 100".
+ */
+class ChangeFilter {
+	float mAbsolute;
+	float mRelative;
+	int64_t mMinInterval;
+	float mLastValue;
+	int64_t mLastTime;
+	bool mHasValue;
+
+public:
+	ChangeFilter(const char* property, float absolute, float relative,
+			int64_t minInterval);
+
+	/* the next value is reported whatever it is */
+	void reset();
+	/* returns true if value is to be reported */
+	bool update(float value, int64_t timestamp);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_CHANGE_FILTER_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+#include "Decimator.h"
+
+/*****************************************************************************/
+
+Decimator::Decimator() :
+	mFactor(1) {
+	reset();
+}
+
+void Decimator::setFactor(int factor) {
+	if (factor < 1)
+		factor = 1;
+	if (factor != mFactor) {
+		mFactor = factor;
+		reset();
+	}
+}
+
+void Decimator::reset() {
+	memset(mSum, 0, sizeof(mSum));
+	memset(mOutput, 0, sizeof(mOutput));
+	mFirstTimestamp = 0;
+	mTimestamp = 0;
+	mCount = 0;
+}
+
+bool Decimator::tick(int64_t timestamp) {
+	if (mCount++ == 0)
+		mFirstTimestamp = timestamp;
+	if (mCount < mFactor)
+		return false;
+	mTimestamp = mFirstTimestamp + (timestamp - mFirstTimestamp) / 2;
+	mCount = 0;
+	return true;
+}
+
+bool Decimator::update(float const* v, int64_t timestamp) {
+	if (mFactor == 1) {
+		mOutput[0] = v[0];
+		mOutput[1] = v[1];
+		mOutput[2] = v[2];
+		mTimestamp = timestamp;
+		return true;
+	}
+
+#ifdef __ARM_NEON__
+	float in[4] __attribute__((aligned(16))) = { v[0], v[1], v[2], 0 };
+	float32x4_t sum = vaddq_f32(vld1q_f32(mSum), vld1q_f32(in));
+	if (!tick(timestamp)) {
+		vst1q_f32(mSum, sum);
+		return false;
+	}
+	vst1q_f32(mOutput, vmulq_n_f32(sum, 1.0f / mFactor));
+	vst1q_f32(mSum, vdupq_n_f32(0));
+#else
+	for (int i = 0; i < 3; i++)
+		mSum[i] += v[i];
+	if (!tick(timestamp))
+		return false;
+	const float scale = 1.0f / mFactor;
+	for (int i = 0; i < 3; i++) {
+		mOutput[i] = mSum[i] * scale;
+		mSum[i] = 0;
+	}
+#endif
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_DECIMATOR_H
+#define ANDROID_DECIMATOR_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Integrate-and-dump (first order CIC) decimator for three axis samples.
+ * Lets an output that asked for a slower rate than the hardware runs at
+ * get the average of each group of samples rather than every Nth one,
+ * which would alias whatever the faster rate picked up.
+ */
+class Decimator {
+	float mSum[4] __attribute__((aligned(16)));
+	float mOutput[4] __attribute__((aligned(16)));
+	int64_t mFirstTimestamp;
+	int64_t mTimestamp;
+	int mFactor;
+	int mCount;
+
+public:
+	Decimator();
+
+	/* keeps one output per factor input samples, restarting the group */
+	void setFactor(int factor);
+	int getFactor() const { return mFactor; }
+	void reset();
+
+	/* returns true once a full group has been averaged */
+	bool update(float const* v, int64_t timestamp);
+	/* returns true once a full group has gone by, without averaging */
+	bool tick(int64_t timestamp);
+
+	float const* getOutput() const { return mOutput; }
+	/* middle of the group, where the average actually sits in time */
+	int64_t getTimestamp() const { return mTimestamp; }
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_DECIMATOR_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cutils/ashmem.h>
+#include <cutils/atomic.h>
+#include <cutils/log.h>
+
+#include "DirectChannel.h"
+
+/*****************************************************************************/
+
+DirectChannel::DirectChannel() :
+	mFd(-1), mBase(MAP_FAILED), mLength(0), mHeader(NULL), mSlots(NULL) {
+}
+
+DirectChannel::~DirectChannel() {
+	if (mBase != MAP_FAILED)
+		munmap(mBase, mLength);
+	if (mFd >= 0)
+		close(mFd);
+}
+
+int DirectChannel::init(int32_t handle, uint32_t numEvents) {
+	mLength = sizeof(direct_channel_header_t)
+			+ numEvents * sizeof(direct_channel_slot_t);
+	mFd = ashmem_create_region("gsensors-direct", mLength);
+	if (mFd < 0) {
+		ALOGE("DirectChannel: couldn't create the ring (%s)", strerror(errno));
+		return -errno;
+	}
+	mBase = mmap(NULL, mLength, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+	if (mBase == MAP_FAILED) {
+		ALOGE("DirectChannel: couldn't map the ring (%s)", strerror(errno));
+		return -errno;
+	}
+	// what is mapped from now on, by the consumers, is read only
+	if (ashmem_set_prot_region(mFd, PROT_READ) < 0) {
+		ALOGE("DirectChannel: couldn't protect the ring (%s)", strerror(errno));
+		return -errno;
+	}
+
+	mHeader = static_cast<direct_channel_header_t*> (mBase);
+	mSlots = reinterpret_cast<direct_channel_slot_t*> (mHeader + 1);
+	memset(mBase, 0, mLength);
+	mHeader->magic = DIRECT_CHANNEL_MAGIC;
+	mHeader->version = DIRECT_CHANNEL_VERSION;
+	mHeader->handle = handle;
+	mHeader->size = numEvents;
+	mHeader->slotSize = sizeof(direct_channel_slot_t);
+	return 0;
+}
+
+void DirectChannel::write(sensors_event_t const* events, int count) {
+	uint32_t n = mHeader->counter;
+
+	for (int i = 0; i < count; i++, n++) {
+		direct_channel_slot_t* slot = &mSlots[n % mHeader->size];
+		android_atomic_release_store(int32_t(2 * n + 1), (volatile int32_t*)
+				&slot->seq);
+		// readers check the sequence again after their copy
+		__sync_synchronize();
+		slot->event = events[i];
+		android_atomic_release_store(int32_t(2 * (n + 1)),
+				(volatile int32_t*) &slot->seq);
+	}
+	android_atomic_release_store(int32_t(n),
+			(volatile int32_t*) &mHeader->counter);
+}
+
+int DirectChannel::read(void const* base, uint32_t* next,
+		sensors_event_t* event) {
+	direct_channel_header_t const* header =
+			static_cast<direct_channel_header_t const*> (base);
+	direct_channel_slot_t const* slots =
+			reinterpret_cast<direct_channel_slot_t const*> (header + 1);
+
+	const uint32_t n = *next;
+	const uint32_t counter = uint32_t(android_atomic_acquire_load(
+			(volatile int32_t const*) &header->counter));
+	if (int32_t(counter - n) <= 0)
+		return 0;
+	if (counter - n > header->size) {
+		*next = counter - header->size;
+		return -EAGAIN;
+	}
+
+	direct_channel_slot_t const* slot = &slots[n % header->size];
+	const uint32_t seq = uint32_t(android_atomic_acquire_load(
+			(volatile int32_t const*) &slot->seq));
+	*event = slot->event;
+	__sync_synchronize();
+	if (seq != 2 * (n + 1) || slot->seq != seq) {
+		// overwritten under us, whatever is left is newer
+		*next = uint32_t(android_atomic_acquire_load((volatile int32_t const*)
+				&header->counter)) - header->size + 1;
+		return -EAGAIN;
+	}
+	*next = n + 1;
+	return 1;
+}
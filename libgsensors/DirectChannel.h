@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_DIRECT_CHANNEL_H
+#define ANDROID_DIRECT_CHANNEL_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+
+/*****************************************************************************/
+
+/*
+ * Ring of the events of one sensor handle in shared memory, for consumers
+ * that would rather map it than receive each event through poll() and
+ * binder. The HAL is the only writer; any number of readers map it read
+ * only and follow it at their own pace without ever holding it up.
+ *
+ * Each slot carries a sequence number which is odd while the slot is
+ * being written and 2 * (n + 1) once it holds event number n. A reader
+ * wanting event n copies the slot between two loads of its sequence and
+ * keeps the copy if both read 2 * (n + 1); a larger value means the
+ * writer lapped it, and it should skip ahead to counter - size.
+ */
+struct direct_channel_header_t {
+	uint32_t magic;
+	uint32_t version;
+	int32_t handle;
+	// slots in the ring, and bytes from one to the next
+	uint32_t size;
+	uint32_t slotSize;
+	uint32_t reserved;
+	// events written so far, the next one goes to slot counter % size
+	volatile uint32_t counter;
+	uint32_t reserved2;
+};
+
+struct direct_channel_slot_t {
+	volatile uint32_t seq;
+	uint32_t reserved;
+	sensors_event_t event;
+};
+
+/*
+ * sent to DIRECT_SOCKET_NAME, answered with a status and the ring fd.
+ * There is one ring per handle, shared by all of its clients and
+ * written at the shortest period any of them asked for: period_ns is
+ * the slowest a client gets events, not a rate it is held to, and a
+ * client wanting fewer has to skip them on its side.
+ */
+struct direct_channel_request_t {
+	int32_t handle;
+	int32_t reserved;
+	int64_t period_ns;
+};
+
+#define DIRECT_CHANNEL_MAGIC	0x47534443	// 'GSDC'
+#define DIRECT_CHANNEL_VERSION	1
+#define DIRECT_SOCKET_NAME		"gsensors_direct"
+
+class DirectChannel {
+	int mFd;
+	void* mBase;
+	size_t mLength;
+	direct_channel_header_t* mHeader;
+	direct_channel_slot_t* mSlots;
+
+public:
+	DirectChannel();
+	~DirectChannel();
+
+	/* creates the shared ring, numEvents long */
+	int init(int32_t handle, uint32_t numEvents);
+	/* the fd consumers map, PROT_READ only */
+	int getFd() const { return mFd; }
+	/* writer side, from a single thread at a time */
+	void write(sensors_event_t const* events, int count);
+
+	/*
+	 * reader side, on a mapping of the ring: copies event *next into
+	 * event and advances *next; returns 1, 0 if it is not written yet,
+	 * or -EAGAIN after skipping *next ahead of events it was lapped on
+	 */
+	static int read(void const* base, uint32_t* next, sensors_event_t* event);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_DIRECT_CHANNEL_H
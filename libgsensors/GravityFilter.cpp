@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+#include "GravityFilter.h"
+
+/*****************************************************************************/
+
+/* time constant of the gravity low-pass, in nanoseconds */
+#define GRAVITY_TIME_CONSTANT	200000000.0f
+/* gaps longer than this restart the filter from the current sample */
+#define MAX_SAMPLE_GAP			1000000000LL
+
+GravityFilter::GravityFilter() {
+	reset();
+}
+
+void GravityFilter::reset() {
+	memset(mGravity, 0, sizeof(mGravity));
+	memset(mLinear, 0, sizeof(mLinear));
+	mLastTimestamp = 0;
+	mInitialized = false;
+}
+
+void GravityFilter::update(float const* accel, int64_t timestamp) {
+	int64_t dt = timestamp - mLastTimestamp;
+
+	mLastTimestamp = timestamp;
+	if (!mInitialized || dt <= 0 || dt > MAX_SAMPLE_GAP) {
+		mGravity[0] = accel[0];
+		mGravity[1] = accel[1];
+		mGravity[2] = accel[2];
+		mGravity[3] = 0;
+		memset(mLinear, 0, sizeof(mLinear));
+		mInitialized = true;
+		return;
+	}
+
+	const float alpha = dt / (GRAVITY_TIME_CONSTANT + dt);
+#ifdef __ARM_NEON__
+	float in[4] __attribute__((aligned(16))) = { accel[0], accel[1], accel[2], 0 };
+	float32x4_t a = vld1q_f32(in);
+	float32x4_t g = vld1q_f32(mGravity);
+	g = vmlaq_n_f32(g, vsubq_f32(a, g), alpha);
+	vst1q_f32(mGravity, g);
+	vst1q_f32(mLinear, vsubq_f32(a, g));
+#else
+	for (int i = 0; i < 3; i++) {
+		mGravity[i] += alpha * (accel[i] - mGravity[i]);
+		mLinear[i] = accel[i] - mGravity[i];
+	}
+#endif
+}
+
+void GravityFilter::getOrientation(float* pitch, float* roll) const {
+	const float g_x = mGravity[0];
+	const float g_y = mGravity[1];
+	const float g_z = mGravity[2];
+
+	// pitch is positive when z moves toward y, roll when x moves toward z
+	*pitch = atan2f(-g_y, g_z) * (180.0f / M_PI);
+	*roll = atan2f(g_x, sqrtf(g_y * g_y + g_z * g_z)) * (180.0f / M_PI);
+}
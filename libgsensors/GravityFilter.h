@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GRAVITY_FILTER_H
+#define ANDROID_GRAVITY_FILTER_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * First order low-pass splitting the accelerometer signal into gravity
+ * and linear acceleration. It runs once per accelerometer sample and
+ * feeds all the virtual sensors derived from it; the vectors are kept
+ * four wide so that the update is a couple of NEON instructions.
+ */
+class GravityFilter {
+	float mGravity[4] __attribute__((aligned(16)));
+	float mLinear[4] __attribute__((aligned(16)));
+	int64_t mLastTimestamp;
+	bool mInitialized;
+
+public:
+	GravityFilter();
+
+	void reset();
+	void update(float const* accel, int64_t timestamp);
+
+	float const* getGravity() const { return mGravity; }
+	float const* getLinearAcceleration() const { return mLinear; }
+	/* pitch and roll in degrees, following the legacy orientation sensor */
+	void getOrientation(float* pitch, float* roll) const;
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_GRAVITY_FILTER_H
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cutils/log.h>
+
+#include "IioBuffer.h"
+
+/*****************************************************************************/
+
+IioBuffer::IioBuffer(const char* sysfsDir, const char* devPath) :
+	mSysfsDir(sysfsDir), mDevPath(devPath), mNumChannels(0), mTimestamp(-1),
+			mRecordSize(0), mFd(-1), mMonotonic(false) {
+}
+
+IioBuffer::~IioBuffer() {
+	disable();
+}
+
+int IioBuffer::writeAttribute(const char* name, const char* value) const {
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", mSysfsDir, name);
+	int fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	int err = write(fd, value, strlen(value)) < 0 ? -errno : 0;
+	close(fd);
+	return err;
+}
+
+int IioBuffer::readAttribute(const char* name, char* value, size_t size) const {
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", mSysfsDir, name);
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	ssize_t amt = ::read(fd, value, size - 1);
+	close(fd);
+	if (amt <= 0)
+		return amt < 0 ? -errno : -ENODATA;
+	value[amt] = '\0';
+	return 0;
+}
+
+/*
+ * Looks up a scan element and parses its type, e.g. "le:s12/16>>4": little
+ * endian, signed, 12 significant bits stored in 16, shifted left by 4.
+ */
+int IioBuffer::addScanElement(const char* name) {
+	char attr[64];
+	char value[32];
+	Channel& c = mChannels[mNumChannels];
+
+	snprintf(attr, sizeof(attr), "scan_elements/%s_index", name);
+	if (readAttribute(attr, value, sizeof(value)) < 0)
+		return -ENOENT;
+	c.index = atoi(value);
+
+	char endian[3], sign;
+	snprintf(attr, sizeof(attr), "scan_elements/%s_type", name);
+	if (readAttribute(attr, value, sizeof(value)) < 0 || sscanf(value,
+			"%2[bl]e:%c%d/%d>>%d", endian, &sign, &c.bits, &c.bytes, &c.shift)
+			!= 5) {
+		ALOGE("IioBuffer: can't parse the type of %s", name);
+		return -EINVAL;
+	}
+	c.bigEndian = endian[0] == 'b';
+	c.isSigned = sign == 's';
+	c.bytes /= 8;
+	if (c.bytes != 1 && c.bytes != 2 && c.bytes != 4 && c.bytes != 8)
+		return -EINVAL;
+
+	strncpy(c.name, name, sizeof(c.name) - 1);
+	c.name[sizeof(c.name) - 1] = '\0';
+	return mNumChannels++;
+}
+
+int IioBuffer::addChannel(const char* name) {
+	if (mNumChannels >= MAX_CHANNELS || mFd >= 0)
+		return -ENOSPC;
+	return addScanElement(name);
+}
+
+/* records hold the elements by index, each aligned on its own size */
+void IioBuffer::layout() {
+	int offset = 0;
+	int align = 1;
+
+	for (int index = 0, placed = 0; placed < mNumChannels; index++) {
+		for (int i = 0; i < mNumChannels; i++) {
+			Channel& c = mChannels[i];
+			if (c.index != index)
+				continue;
+			offset = (offset + c.bytes - 1) & ~(c.bytes - 1);
+			c.offset = offset;
+			offset += c.bytes;
+			if (c.bytes > align)
+				align = c.bytes;
+			placed++;
+		}
+	}
+	mRecordSize = (offset + align - 1) & ~(align - 1);
+}
+
+int IioBuffer::enable(const char* trigger, int length) {
+	char value[16];
+
+	if (mFd >= 0)
+		return 0;
+	if (mNumChannels == 0)
+		return -EINVAL;
+
+	// the timestamp element goes last so it does not shift the channels
+	mTimestamp = addScanElement("in_timestamp");
+	if (mTimestamp < 0)
+		mTimestamp = -1;
+	layout();
+	if (mRecordSize > MAX_RECORD) {
+		disable();
+		return -E2BIG;
+	}
+
+	int err = 0;
+	for (int i = 0; i < mNumChannels && err == 0; i++)
+		err = setScanElement(mChannels[i].name, true);
+
+	// drivers that trigger themselves have no current_trigger
+	if (trigger)
+		writeAttribute("trigger/current_trigger", trigger);
+	// stamp with the clock all the other sensors use, where supported
+	mMonotonic = writeAttribute("current_timestamp_clock", "monotonic\n") == 0;
+	snprintf(value, sizeof(value), "%d", length);
+	if (err == 0)
+		err = writeAttribute("buffer/length", value);
+	if (err == 0)
+		err = writeAttribute("buffer/enable", "1");
+	if (err == 0) {
+		mFd = open(mDevPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (mFd < 0)
+			err = -errno;
+	}
+	if (err < 0) {
+		ALOGE("IioBuffer: couldn't enable %s (%s)", mDevPath, strerror(-err));
+		disable();
+	}
+	return err;
+}
+
+void IioBuffer::disable() {
+	if (mNumChannels == 0)
+		return;
+	if (mFd >= 0) {
+		close(mFd);
+		mFd = -1;
+	}
+	writeAttribute("buffer/enable", "0");
+	for (int i = 0; i < mNumChannels; i++)
+		setScanElement(mChannels[i].name, false);
+	if (mTimestamp >= 0) {
+		mNumChannels--;
+		mTimestamp = -1;
+	}
+}
+
+int IioBuffer::setScanElement(const char* name, bool enable) {
+	char attr[64];
+
+	snprintf(attr, sizeof(attr), "scan_elements/%s_en", name);
+	return writeAttribute(attr, enable ? "1" : "0");
+}
+
+int64_t IioBuffer::decode(const uint8_t* record, Channel const& c) const {
+	const uint8_t* p = record + c.offset;
+	uint64_t raw = 0;
+
+	for (int i = 0; i < c.bytes; i++) {
+		int b = c.bigEndian ? i : c.bytes - 1 - i;
+		raw = (raw << 8) | p[b];
+	}
+	raw >>= c.shift;
+	if (c.bits < 64) {
+		raw &= (1ULL << c.bits) - 1;
+		if (c.isSigned && (raw & (1ULL << (c.bits - 1))))
+			raw |= ~((1ULL << c.bits) - 1);
+	}
+	return int64_t(raw);
+}
+
+int IioBuffer::read(Record* records, int count) {
+	if (mFd < 0)
+		return -EBADF;
+
+	int max = sizeof(mBuffer) / mRecordSize;
+	if (count > max)
+		count = max;
+	ssize_t amt = ::read(mFd, mBuffer, count * mRecordSize);
+	if (amt < 0)
+		return -errno;
+
+	int n = amt / mRecordSize;
+	const int numValues = mTimestamp >= 0 ? mNumChannels - 1 : mNumChannels;
+	for (int r = 0; r < n; r++) {
+		const uint8_t* record = mBuffer + r * mRecordSize;
+		for (int i = 0; i < numValues; i++)
+			records[r].values[i] = decode(record, mChannels[i]);
+		records[r].timestamp = mTimestamp >= 0 ? decode(record,
+				mChannels[mTimestamp]) : 0;
+	}
+	return n;
+}
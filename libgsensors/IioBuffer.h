@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_IIO_BUFFER_H
+#define ANDROID_IIO_BUFFER_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Buffered capture from an IIO device: the scan elements asked for are
+ * enabled along with the timestamp, and whole scan records are read in
+ * bulk from the device node, each channel decoded according to the type
+ * descriptor the driver publishes in scan_elements.
+ */
+class IioBuffer {
+public:
+	enum {
+		MAX_CHANNELS = 4,
+		MAX_RECORD = 64,
+	};
+
+	struct Record {
+		int64_t values[MAX_CHANNELS];
+		int64_t timestamp;
+	};
+
+private:
+	struct Channel {
+		char name[32];
+		int index;
+		int offset;
+		int bytes;
+		int bits;
+		int shift;
+		bool isSigned;
+		bool bigEndian;
+	};
+
+	const char* const mSysfsDir;
+	const char* const mDevPath;
+	Channel mChannels[MAX_CHANNELS + 1];
+	int mNumChannels;
+	int mTimestamp;
+	int mRecordSize;
+	int mFd;
+	bool mMonotonic;
+	uint8_t mBuffer[MAX_RECORD * 16] __attribute__((aligned(8)));
+
+	int writeAttribute(const char* name, const char* value) const;
+	int readAttribute(const char* name, char* value, size_t size) const;
+	int addScanElement(const char* name);
+	int setScanElement(const char* name, bool enable);
+	void layout();
+	int64_t decode(const uint8_t* record, Channel const& c) const;
+
+public:
+	IioBuffer(const char* sysfsDir, const char* devPath);
+	~IioBuffer();
+
+	/* returns the position of the channel in Record::values */
+	int addChannel(const char* name);
+	int enable(const char* trigger, int length);
+	void disable();
+	int getFd() const { return mFd; }
+	/* false when the timestamps are still on CLOCK_REALTIME */
+	bool isMonotonic() const { return mMonotonic; }
+	/* reads the records available, -EAGAIN when there are none */
+	int read(Record* records, int count);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_IIO_BUFFER_H
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <cutils/log.h>
+#include <linux/input.h>
+
+#include "InputDeviceIndex.h"
+
+/*****************************************************************************/
+
+#define INPUT_DIR	"/dev/input"
+
+InputDeviceIndex::InputDeviceIndex() :
+	mCount(0), mScanned(false) {
+	pthread_mutex_init(&mLock, NULL);
+	mInotifyFd = inotify_init();
+	if (mInotifyFd < 0) {
+		ALOGE("error creating inotify fd (%s)", strerror(errno));
+		return;
+	}
+	fcntl(mInotifyFd, F_SETFL, O_NONBLOCK);
+	fcntl(mInotifyFd, F_SETFD, FD_CLOEXEC);
+	// nodes show up root owned and get their permissions afterwards
+	if (inotify_add_watch(mInotifyFd, INPUT_DIR,
+			IN_CREATE | IN_ATTRIB | IN_DELETE) < 0)
+		ALOGE("error watching %s (%s)", INPUT_DIR, strerror(errno));
+}
+
+InputDeviceIndex::~InputDeviceIndex() {
+	if (mInotifyFd >= 0)
+		close(mInotifyFd);
+	pthread_mutex_destroy(&mLock);
+}
+
+InputDeviceIndex& InputDeviceIndex::getInstance() {
+	static InputDeviceIndex sInstance;
+	return sInstance;
+}
+
+bool InputDeviceIndex::addNode(const char* node) {
+	char path[PATH_MAX];
+	char name[MAX_NAME];
+
+	if (strlen(node) >= MAX_NODE)
+		return false;
+	snprintf(path, sizeof(path), INPUT_DIR "/%s", node);
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), &name) < 1)
+		name[0] = '\0';
+	close(fd);
+	name[sizeof(name) - 1] = '\0';
+
+	removeNode(node);
+	if (mCount == MAX_DEVICES) {
+		ALOGE("too many input devices, ignoring %s", node);
+		return false;
+	}
+	strcpy(mEntries[mCount].name, name);
+	strcpy(mEntries[mCount].node, node);
+	mCount++;
+	return true;
+}
+
+bool InputDeviceIndex::removeNode(const char* node) {
+	for (int i = 0; i < mCount; i++) {
+		if (!strcmp(mEntries[i].node, node)) {
+			mEntries[i] = mEntries[--mCount];
+			return true;
+		}
+	}
+	return false;
+}
+
+void InputDeviceIndex::scan() {
+	DIR* dir = opendir(INPUT_DIR);
+	struct dirent* de;
+
+	mCount = 0;
+	mScanned = true;
+	if (dir == NULL)
+		return;
+	while ((de = readdir(dir))) {
+		if (de->d_name[0] == '.')
+			continue;
+		addNode(de->d_name);
+	}
+	closedir(dir);
+}
+
+bool InputDeviceIndex::drain() {
+	char buffer[512] __attribute__((aligned(__alignof__(struct inotify_event))));
+	bool changed = false;
+	ssize_t n;
+
+	if (mInotifyFd < 0)
+		return false;
+	while ((n = read(mInotifyFd, buffer, sizeof(buffer))) > 0) {
+		for (char* p = buffer; p < buffer + n;) {
+			struct inotify_event* ev = (struct inotify_event*) p;
+			p += sizeof(*ev) + ev->len;
+			if (ev->mask & IN_Q_OVERFLOW) {
+				// lost track, start over on the next lookup
+				mScanned = false;
+				changed = true;
+			} else if (!mScanned || !ev->len) {
+				continue;
+			} else if (ev->mask & IN_DELETE) {
+				changed |= removeNode(ev->name);
+			} else {
+				changed |= addNode(ev->name);
+			}
+		}
+	}
+	return changed;
+}
+
+int InputDeviceIndex::open(const char* name, char* node, size_t size) {
+	int fd = -1;
+
+	pthread_mutex_lock(&mLock);
+	drain();
+	if (!mScanned)
+		scan();
+	for (int i = 0; i < mCount; i++) {
+		if (strcmp(mEntries[i].name, name))
+			continue;
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), INPUT_DIR "/%s", mEntries[i].node);
+		// drivers read whenever they have room, not only when poll says
+		// so, and must never wait in read() for the next sample
+		fd = ::open(path, O_RDONLY | O_NONBLOCK);
+		if (fd >= 0 && node)
+			snprintf(node, size, "%s", mEntries[i].node);
+		break;
+	}
+	pthread_mutex_unlock(&mLock);
+	return fd;
+}
+
+int InputDeviceIndex::getFd() const {
+	return mInotifyFd;
+}
+
+bool InputDeviceIndex::processEvents() {
+	pthread_mutex_lock(&mLock);
+	bool changed = drain();
+	pthread_mutex_unlock(&mLock);
+	return changed;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INPUT_DEVICE_INDEX_H
+#define ANDROID_INPUT_DEVICE_INDEX_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Process wide map from input device name to /dev/input node. The
+ * directory is scanned once, then kept current through inotify, so
+ * drivers find their device without probing every node on each HAL
+ * open and can pick up a device that shows up later.
+ */
+class InputDeviceIndex {
+	enum {
+		MAX_DEVICES = 32,
+		MAX_NAME = 80,
+		MAX_NODE = 32,
+	};
+
+	struct Entry {
+		char name[MAX_NAME];
+		char node[MAX_NODE];
+	};
+
+	pthread_mutex_t mLock;
+	Entry mEntries[MAX_DEVICES];
+	int mCount;
+	int mInotifyFd;
+	bool mScanned;
+
+	InputDeviceIndex();
+	~InputDeviceIndex();
+
+	void scan();
+	bool addNode(const char* node);
+	bool removeNode(const char* node);
+	bool drain();
+
+public:
+	static InputDeviceIndex& getInstance();
+
+	/* opens the device called name and stores its node, -1 if absent */
+	int open(const char* name, char* node, size_t size);
+	/* readable when /dev/input changed, then call processEvents() */
+	int getFd() const;
+	/* returns true if a device was added or removed */
+	bool processEvents();
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_INPUT_DEVICE_INDEX_H
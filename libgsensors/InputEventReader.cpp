@@ -33,7 +33,7 @@
 struct input_event;
 
 InputEventCircularReader::InputEventCircularReader(size_t numEvents)
-    : mBuffer(new input_event[numEvents * 2]),
+    : mBuffer(new input_event[numEvents]),
       mBufferEnd(mBuffer + numEvents),
       mHead(mBuffer),
       mCurr(mBuffer),
@@ -50,7 +50,12 @@ ssize_t InputEventCircularReader::fill(int fd)
 {
     size_t numEventsRead = 0;
     if (mFreeSpace) {
-        const ssize_t nread = read(fd, mHead, mFreeSpace * sizeof(input_event));
+        // only read up to the end of the ring, the rest of the free
+        // space is filled once the head has wrapped around
+        size_t room = mBufferEnd - mHead;
+        if (room > size_t(mFreeSpace))
+            room = mFreeSpace;
+        const ssize_t nread = read(fd, mHead, room * sizeof(input_event));
         if (nread<0 || nread % sizeof(input_event)) {
             // we got a partial event!!
             return nread<0 ? -errno : -EINVAL;
@@ -60,10 +65,8 @@ ssize_t InputEventCircularReader::fill(int fd)
         if (numEventsRead) {
             mHead += numEventsRead;
             mFreeSpace -= numEventsRead;
-            if (mHead > mBufferEnd) {
-                size_t s = mHead - mBufferEnd;
-                memcpy(mBuffer, mBufferEnd, s * sizeof(input_event));
-                mHead = mBuffer + s;
+            if (mHead >= mBufferEnd) {
+                mHead = mBuffer;
             }
         }
     }
@@ -71,18 +74,39 @@ ssize_t InputEventCircularReader::fill(int fd)
     return numEventsRead;
 }
 
-ssize_t InputEventCircularReader::readEvent(input_event const** events)
+ssize_t InputEventCircularReader::readEvents(input_event const** events)
 {
+    const ssize_t available = (mBufferEnd - mBuffer) - mFreeSpace;
+    const ssize_t contiguous = mBufferEnd - mCurr;
     *events = mCurr;
-    ssize_t available = (mBufferEnd - mBuffer) - mFreeSpace;
-    return available ? 1 : 0;
+    return available < contiguous ? available : contiguous;
 }
 
-void InputEventCircularReader::next()
+void InputEventCircularReader::consume(size_t count)
 {
-    mCurr++;
-    mFreeSpace++;
+    mCurr += count;
+    mFreeSpace += count;
     if (mCurr >= mBufferEnd) {
-        mCurr = mBuffer;
+        mCurr -= mBufferEnd - mBuffer;
     }
 }
+
+size_t InputEventCircularReader::getCount() const {
+    return (mBufferEnd - mBuffer) - mFreeSpace;
+}
+
+void InputEventCircularReader::reset()
+{
+    mHead = mCurr = mBuffer;
+    mFreeSpace = mBufferEnd - mBuffer;
+}
+
+ssize_t InputEventCircularReader::readEvent(input_event const** events)
+{
+    return readEvents(events) ? 1 : 0;
+}
+
+void InputEventCircularReader::next()
+{
+    consume(1);
+}
@@ -26,6 +26,12 @@
 
 struct input_event;
 
+/*
+ * Ring of input_events read from an evdev fd. fill() only ever reads
+ * into the contiguous free space after the head, so events are never
+ * copied around; readEvents() hands out the longest contiguous span of
+ * unread events and consume() releases them.
+ */
 class InputEventCircularReader
 {
     struct input_event* const mBuffer;
@@ -38,6 +44,12 @@ public:
     InputEventCircularReader(size_t numEvents);
     ~InputEventCircularReader();
     ssize_t fill(int fd);
+    ssize_t readEvents(input_event const** events);
+    void consume(size_t count);
+    /* events read from the fd but not consumed yet */
+    size_t getCount() const;
+    /* drops whatever is left, e.g. once the device is gone */
+    void reset();
     ssize_t readEvent(input_event const** events);
     void next();
 };
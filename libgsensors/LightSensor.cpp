@@ -15,7 +15,12 @@
  */
 
 #include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 #include <cutils/log.h>
+#include <cutils/properties.h>
 #include <stdlib.h>
 
 #include "LightSensor.h"
@@ -23,7 +28,22 @@
 /*****************************************************************************/
 
 #define FIRST_GOOD_EVENT    5
-#define LUX_SYSFS_PATH  "/sys/bus/iio/devices/device0/lux"
+#define LIGHT_IIO_DIR   SYSFS_ROOT "/sys/bus/iio/devices/device0"
+#define LIGHT_IIO_DEV   "/dev/iio:device0"
+#define LUX_SYSFS_PATH  LIGHT_IIO_DIR "/lux"
+#define SCALE_SYSFS_PATH LIGHT_IIO_DIR "/in_illuminance0_scale"
+#define FREQ_SYSFS_PATH LIGHT_IIO_DIR "/sampling_frequency"
+
+/*
+ * a new lux value is reported once it is 10% or 1 lux, whichever is
+ * larger, off the last one reported; ro.sensors.light.change overrides
+ */
+#define LUX_CHANGE_ABSOLUTE 1.0f
+#define LUX_CHANGE_RELATIVE 0.1f
+#define LUX_CHANGE_INTERVAL 0
+
+/* scan records fetched from the IIO buffer per read */
+#define NUM_RECORDS     16
 
 /* return the current time in nanoseconds */
 int64_t now_ns(void)
@@ -40,10 +60,26 @@ LightSensor::LightSensor()
     : SensorBase(NULL, NULL),
       mEnabled(0),
       mHasPendingEvent(false),
-      mAlready_warned(false),
-      mLast_value(-1)
+      mFilter("ro.sensors.light.change", LUX_CHANGE_ABSOLUTE,
+              LUX_CHANGE_RELATIVE, LUX_CHANGE_INTERVAL),
+      mLux(LUX_SYSFS_PATH, O_RDONLY),
+      mBuffer(LIGHT_IIO_DIR, LIGHT_IIO_DEV),
+      mScale(SCALE_SYSFS_PATH, O_RDONLY),
+      mFrequency(FREQ_SYSFS_PATH, O_WRONLY),
+      mLuxChannel(-1),
+      mBuffered(false),
+      mLuxScale(1.0f)
 {
+    char value[PROPERTY_VALUE_MAX];
+
     delay_time = 200000000LL;
+    open_timer();
+
+    property_get("ro.sensors.light.buffered", value, "0");
+    if (!strcmp(value, "1")) {
+        mLuxChannel = mBuffer.addChannel("in_illuminance0");
+        ALOGE_IF(mLuxChannel < 0, "LightSensor: no illuminance scan element");
+    }
 }
 
 LightSensor::~LightSensor() {
@@ -51,6 +87,38 @@ LightSensor::~LightSensor() {
 
 int LightSensor::setDelay(int32_t handle, int64_t ns) {
     delay_time = ns;
+    if (mBuffered)
+        return setFrequency();
+    if (mEnabled)
+        return set_timer(delay_time);
+    return 0;
+}
+
+/* the trigger samples at the requested rate, rounded to whole Hz */
+int LightSensor::setFrequency() {
+    int64_t hz = delay_time > 0 ? 1000000000LL / delay_time : 0;
+    return mFrequency.write(hz > 0 ? hz : 1);
+}
+
+/*
+ * Switches to buffered capture: scan records carrying the raw count and
+ * a timestamp taken when the sample was converted are read in bulk from
+ * the device node, which then replaces both the attribute and the timer.
+ */
+int LightSensor::enableBuffer() {
+    char trigger[PROPERTY_VALUE_MAX];
+
+    if (mLuxChannel < 0)
+        return -ENODEV;
+    if (mScale.read(&mLuxScale) < 0)
+        mLuxScale = 1.0f;
+    mScale.close();
+    setFrequency();
+    property_get("ro.sensors.light.trigger", trigger, "");
+    int err = mBuffer.enable(trigger[0] ? trigger : NULL, NUM_RECORDS * 4);
+    if (err < 0)
+        return err;
+    mBuffered = true;
     return 0;
 }
 
@@ -59,20 +127,30 @@ int64_t LightSensor::getDelay() const {
 }
 
 int LightSensor::enable(int32_t handle, int en) {
-    if (en != 0)
+    if (en != 0) {
+        /* The attribute is kept open and re-read at offset 0, so that
+         * a sysfs_notify() on it wakes the poll loop through POLLPRI.
+         * The timer samples it every delay_time for drivers which never
+         * notify.
+         */
+        mFilter.reset();
         mEnabled = true;
-    else
+        if (enableBuffer() == 0)
+            return 0;
+        mLux.open();
+        set_timer(delay_time);
+    } else {
         mEnabled = false;
+        if (mBuffered) {
+            mBuffer.disable();
+            mBuffered = false;
+        }
+        set_timer(0);
+        mLux.close();
+    }
     return 0;
 }
 
-bool LightSensor::hasPendingEvents() const {
-    if(mEnabled)
-        return true;
-    else
-        return false;
-}
-
 int LightSensor::readEvents(sensors_event_t* data, int count) {
     static int log_count = 0;
     static float value = -1.0f;
@@ -83,40 +161,54 @@ int LightSensor::readEvents(sensors_event_t* data, int count) {
         return 0;
     }
 
-    /* The opening of the file handle is placed here
-     * as work around that if it is opened in the constructor
-     * read on the file handle fails.
-     */
-    data_fd = open(LUX_SYSFS_PATH, O_RDONLY);
-    if (data_fd < 0)
-        return 0;
-
-    int numEventReceived = 0;
-    input_event const* event;
-    char buffer[20] = {0};
-
-    int amt = read(data_fd, buffer, sizeof(buffer));
-    close(data_fd);
+    if (mBuffered)
+        return readBuffer(data, count);
 
-    if (amt <= 0 && mAlready_warned == false) {
-        ALOGE("LightSensor: read from %s failed", LUX_SYSFS_PATH);
-        mAlready_warned = false;
+    if (mLux.read(&value) < 0)
         return 0;
-    }
-    value = atof(buffer);
-    if (value == mLast_value)
+    int64_t now = now_ns();
+    if (!mFilter.update(value, now))
        return 0;
     evt.version = sizeof(sensors_event_t);
     evt.sensor = ID_L;
     evt.type = SENSOR_TYPE_LIGHT;
     evt.light = value;
-    evt.timestamp = now_ns();
+    evt.timestamp = now;
     *data = evt;
-    mLast_value = value;
     ALOGE("LightSensor: value is %i", (int)value );
     return 1;
 }
 
+int LightSensor::readBuffer(sensors_event_t* data, int count) {
+    IioBuffer::Record records[NUM_RECORDS];
+    int numEventReceived = 0;
+
+    int n = mBuffer.read(records, count < NUM_RECORDS ? count : NUM_RECORDS);
+    if (n <= 0)
+        return 0;
+    const int64_t offset = mBuffer.isMonotonic() ? 0 : getRealtimeOffset();
+    for (int i = 0; i < n; i++) {
+        float value = records[i].values[mLuxChannel] * mLuxScale;
+        int64_t timestamp = records[i].timestamp ?
+                records[i].timestamp - offset : now_ns();
+        if (!mFilter.update(value, timestamp))
+            continue;
+        sensors_event_t* evt = &data[numEventReceived++];
+        memset(evt, 0, sizeof(*evt));
+        evt->version = sizeof(sensors_event_t);
+        evt->sensor = ID_L;
+        evt->type = SENSOR_TYPE_LIGHT;
+        evt->light = value;
+        evt->timestamp = timestamp;
+    }
+    return numEventReceived;
+}
+
 int LightSensor::getFd() const {
-    return -1;
+    return mBuffered ? mBuffer.getFd() : mLux.getFd();
+}
+
+uint32_t LightSensor::getFdEvents() const {
+    // sysfs attributes signal a sysfs_notify() through POLLPRI
+    return mBuffered ? EPOLLIN : EPOLLPRI;
 }
@@ -19,6 +19,8 @@
 
 #include "sensors.h"
 #include "SensorBase.h"
+#include "ChangeFilter.h"
+#include "IioBuffer.h"
 
 /*****************************************************************************/
 
@@ -27,18 +29,29 @@ struct input_event;
 class LightSensor : public SensorBase {
     int mEnabled;
     bool mHasPendingEvent;
-    float mLast_value;
-    bool mAlready_warned;
+    ChangeFilter mFilter;
+    SysfsAttribute mLux;
+    /* optional buffered capture, see ro.sensors.light.buffered */
+    IioBuffer mBuffer;
+    SysfsAttribute mScale;
+    SysfsAttribute mFrequency;
+    int mLuxChannel;
+    bool mBuffered;
+    float mLuxScale;
+
+    int enableBuffer();
+    int setFrequency();
+    int readBuffer(sensors_event_t* data, int count);
 
 public:
             LightSensor();
     virtual ~LightSensor();
     virtual int readEvents(sensors_event_t* data, int count);
-    virtual bool hasPendingEvents() const;
     virtual int setDelay(int32_t handle, int64_t ns);
     virtual int64_t getDelay() const;
     virtual int enable(int32_t handle, int enabled);
     virtual int getFd() const;
+    virtual uint32_t getFdEvents() const;
 
 };
 
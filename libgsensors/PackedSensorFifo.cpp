@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include <string.h>
+
+#include "PackedSensorFifo.h"
+
+/*****************************************************************************/
+
+/* fraction bits of the quantized axes */
+#define AXIS_SHIFT			10
+
+static inline uint64_t zigzag(int64_t v) {
+	return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+	return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+PackedSensorFifo::PackedSensorFifo(int handle, size_t numEvents,
+		size_t numBytes) :
+	SensorFifo(handle, numEvents, false),
+	mBytes(numBytes ? new uint8_t[numBytes] : NULL), mNumBytes(numBytes) {
+	memset(&mTemplate, 0, sizeof(mTemplate));
+	removeAll();
+}
+
+PackedSensorFifo::~PackedSensorFifo() {
+	delete [] mBytes;
+}
+
+void PackedSensorFifo::resetState(State* state) {
+	memset(state, 0, sizeof(*state));
+}
+
+void PackedSensorFifo::put(uint64_t value) {
+	size_t pos = (mRead + mUsed) % mNumBytes;
+	do {
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		mBytes[pos] = value ? byte | 0x80 : byte;
+		if (++pos == mNumBytes)
+			pos = 0;
+		mUsed++;
+	} while (value);
+}
+
+uint64_t PackedSensorFifo::get() {
+	uint64_t value = 0;
+	uint8_t byte;
+	int shift = 0;
+	do {
+		byte = mBytes[mRead];
+		if (++mRead == mNumBytes)
+			mRead = 0;
+		mUsed--;
+		value |= uint64_t(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+bool PackedSensorFifo::isFull() const {
+	return SensorFifo::isFull() || mNumBytes - mUsed < PACKED_EVENT_BYTES_MAX;
+}
+
+void PackedSensorFifo::append(sensors_event_t const& event) {
+	State* s = &mWriteState;
+	const int64_t interval = event.timestamp - s->timestamp;
+
+	put(zigzag(interval - s->interval));
+	s->timestamp = event.timestamp;
+	s->interval = interval;
+	for (int i = 0; i < 3; i++) {
+		int32_t q = int32_t(floorf(event.acceleration.v[i]
+				* (1 << AXIS_SHIFT) + 0.5f));
+		put(zigzag(int64_t(q) - s->axes[i]));
+		s->axes[i] = q;
+	}
+	mTemplate.version = event.version;
+	mTemplate.sensor = event.sensor;
+	mTemplate.type = event.type;
+	mTemplate.acceleration.status = event.acceleration.status;
+}
+
+void PackedSensorFifo::removeOldest(sensors_event_t* event) {
+	State* s = &mReadState;
+
+	s->interval += unzigzag(get());
+	s->timestamp += s->interval;
+	for (int i = 0; i < 3; i++)
+		s->axes[i] += int32_t(unzigzag(get()));
+	if (!event)
+		return;
+
+	*event = mTemplate;
+	event->timestamp = s->timestamp;
+	for (int i = 0; i < 3; i++)
+		event->acceleration.v[i] = float(s->axes[i]) / (1 << AXIS_SHIFT);
+}
+
+void PackedSensorFifo::removeAll() {
+	// both ends start over from zero, the first event is coded in full
+	mRead = 0;
+	mUsed = 0;
+	resetState(&mWriteState);
+	resetState(&mReadState);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKED_SENSOR_FIFO_H
+#define ANDROID_PACKED_SENSOR_FIFO_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "SensorFifo.h"
+
+/*****************************************************************************/
+
+/*
+ * bytes an event takes, as varints of 7 bits a byte: at worst a 64 bit
+ * interval and three 32 bit axes, at best a byte for each
+ */
+#define PACKED_EVENT_BYTES_MAX	(10 + 3 * 5)
+#define PACKED_EVENT_BYTES_MIN	(1 + 3 * 1)
+
+/*
+ * Events a FIFO of numBytes holds whatever they are, and at most. A new
+ * event is only taken while the worst case still fits.
+ */
+#define PACKED_RESERVED_EVENTS(numBytes)	((numBytes) / PACKED_EVENT_BYTES_MAX)
+#define PACKED_MAX_EVENTS(numBytes) \
+	(((numBytes) - PACKED_EVENT_BYTES_MAX) / PACKED_EVENT_BYTES_MIN + 1)
+
+/*
+ * Batch FIFO of a 3-axis vector sensor which keeps each event in a few
+ * bytes rather than a whole sensors_event_t. The axes are quantized to
+ * 1/1024 m/s^2, a tenth of the accelerometer resolution, and stored as
+ * the varint coded difference to the previous event; the timestamp as
+ * the difference of its interval to the previous one, which the
+ * TimestampFilter keeps close to zero. Events are rebuilt from the
+ * differences only as they are drained. The version, type and status of
+ * the last event pushed go to every event rebuilt.
+ */
+class PackedSensorFifo : public SensorFifo {
+	struct State {
+		int64_t timestamp;
+		int64_t interval;
+		int32_t axes[3];
+	};
+
+	uint8_t* const mBytes;
+	const size_t mNumBytes;
+	size_t mRead;
+	size_t mUsed;
+	// what the next event is coded against, at either end of the ring
+	State mWriteState;
+	State mReadState;
+	sensors_event_t mTemplate;
+
+	void put(uint64_t value);
+	uint64_t get();
+	static void resetState(State* state);
+
+protected:
+	virtual bool isFull() const;
+	virtual void append(sensors_event_t const& event);
+	virtual void removeOldest(sensors_event_t* event);
+	virtual void removeAll();
+
+public:
+	/* holds up to numEvents, as long as they fit in numBytes */
+	PackedSensorFifo(int handle, size_t numEvents, size_t numBytes);
+	virtual ~PackedSensorFifo();
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_PACKED_SENSOR_FIFO_H
@@ -15,6 +15,10 @@
  */
 
 #include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
 #include <cutils/log.h>
 #include <stdlib.h>
 
@@ -23,7 +27,25 @@
 /*****************************************************************************/
 
 #define FIRST_GOOD_EVENT    5
-#define PROX_SYSFS_PATH  "/sys/bus/iio/devices/device0/proxim_ir"
+#define PROX_SYSFS_PATH  SYSFS_ROOT "/sys/bus/iio/devices/device0/proxim_ir"
+#define PROX_EVENTS_PATH SYSFS_ROOT "/sys/bus/iio/devices/device0/events/"
+#define PROX_CLOCK_PATH  SYSFS_ROOT "/sys/bus/iio/devices/device0/current_timestamp_clock"
+#define PROX_IIO_DEV     "/dev/iio:device0"
+
+/* raw readings above NEAR are near, below FAR far, in between unchanged */
+#define NEAR_THRESHOLD      5000
+#define FAR_THRESHOLD       4000
+
+/* from linux/iio/events.h, which the platform headers do not carry */
+#define IIO_GET_EVENT_FD_IOCTL          _IOR('i', 0x90, int)
+#define IIO_EVENT_CODE_EXTRACT_DIR(id)  ((int)(((id) >> 48) & 0x7F))
+#define IIO_EV_DIR_RISING               1
+#define IIO_EV_DIR_FALLING              2
+
+struct iio_event_data {
+    uint64_t id;
+    int64_t timestamp;
+};
 
 /* return the current time in nanoseconds */
 extern int64_t now_ns(void);
@@ -32,17 +54,27 @@ ProximitySensor::ProximitySensor()
     : SensorBase(NULL, NULL),
       mEnabled(0),
       mHasPendingEvent(false),
-      mAlready_warned(false),
-      mLast_value(-1)
+      mNear(false),
+      mEventFd(-1),
+      mEventsMonotonic(false),
+      mProx(PROX_SYSFS_PATH, O_RDONLY),
+      mRisingValue(PROX_EVENTS_PATH "in_proximity_thresh_rising_value", O_WRONLY),
+      mRisingEnable(PROX_EVENTS_PATH "in_proximity_thresh_rising_en", O_WRONLY),
+      mFallingValue(PROX_EVENTS_PATH "in_proximity_thresh_falling_value", O_WRONLY),
+      mFallingEnable(PROX_EVENTS_PATH "in_proximity_thresh_falling_en", O_WRONLY)
 {
     delay_time = 200000000LL;
+    open_timer();
 }
 
 ProximitySensor::~ProximitySensor() {
+    closeEvents();
 }
 
 int ProximitySensor::setDelay(int32_t handle, int64_t ns) {
     delay_time = ns;
+    if (mEnabled && mEventFd < 0)
+        return set_timer(delay_time);
     return 0;
 }
 
@@ -50,56 +82,149 @@ int64_t ProximitySensor::getDelay() const {
     return delay_time;
 }
 
+int ProximitySensor::openEvents() {
+    // only one event fd is handed out per device, give back ours first
+    closeEvents();
+
+    int fd = open(PROX_IIO_DEV, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -errno;
+    int err = ioctl(fd, IIO_GET_EVENT_FD_IOCTL, &mEventFd) < 0 ? -errno : 0;
+    close(fd);
+    if (err < 0) {
+        mEventFd = -1;
+        return err;
+    }
+    fcntl(mEventFd, F_SETFL, O_NONBLOCK);
+
+    // stamp with the clock all the other sensors use, where supported
+    fd = open(PROX_CLOCK_PATH, O_WRONLY | O_CLOEXEC);
+    mEventsMonotonic = fd >= 0 && write(fd, "monotonic\n", 10) == 10;
+    if (fd >= 0)
+        close(fd);
+
+    if (mRisingValue.write(NEAR_THRESHOLD) < 0 ||
+            mFallingValue.write(FAR_THRESHOLD) < 0) {
+        closeEvents();
+        return -EINVAL;
+    }
+    return 0;
+}
+
+void ProximitySensor::closeEvents() {
+    if (mEventFd < 0)
+        return;
+    mRisingEnable.write(0);
+    mFallingEnable.write(0);
+    mRisingValue.close();
+    mRisingEnable.close();
+    mFallingValue.close();
+    mFallingEnable.close();
+    close(mEventFd);
+    mEventFd = -1;
+}
+
+/* only the crossing that would change the reported state can fire */
+int ProximitySensor::armThreshold() {
+    if (mRisingEnable.write(!mNear) < 0 || mFallingEnable.write(mNear) < 0)
+        return -EINVAL;
+    return 0;
+}
+
+bool ProximitySensor::readNear() {
+    float value;
+    if (mProx.read(&value) < 0)
+        return mNear;
+    return value > (mNear ? FAR_THRESHOLD : NEAR_THRESHOLD);
+}
+
 int ProximitySensor::enable(int32_t handle, int en) {
     if (en != 0) {
-        mLast_value = -1;
+        mProx.open();
+        mNear = false;
+        mNear = readNear();
+        // without the enable attributes no threshold would ever fire
+        int err = openEvents();
+        if (err == 0)
+            err = armThreshold();
+        if (err == 0) {
+            // a crossing before the threshold was armed went unnoticed
+            bool near = readNear();
+            if (near != mNear) {
+                mNear = near;
+                err = armThreshold();
+            }
+        }
+        if (err == 0) {
+            set_timer(0);
+        } else {
+            closeEvents();
+            ALOGD("ProximitySensor: no threshold events, sampling instead");
+            set_timer(delay_time);
+        }
+        // the current state goes out right away
+        mHasPendingEvent = true;
         mEnabled = true;
+    } else {
+        mEnabled = false;
+        mHasPendingEvent = false;
+        set_timer(0);
+        closeEvents();
+        mProx.close();
     }
-    else
-       mEnabled = false;
     return 0;
 }
 
 bool ProximitySensor::hasPendingEvents() const {
-    if(mEnabled)
-        return true;
-    else
-        return false;
+    return mHasPendingEvent;
 }
 
 int ProximitySensor::readEvents(sensors_event_t* data, int count) {
-    static int log_count = 0;
-    float value = -1.0f;
-
     if (count < 1 || data == NULL || !mEnabled)
         return 0;
 
-    data_fd = open(PROX_SYSFS_PATH, O_RDONLY);
-    if (data_fd < 0)
-        return 0;
-
-    char buffer[20] = {0};
-    int amt = read(data_fd, buffer, sizeof(buffer));
-    close(data_fd);
+    bool near = mNear;
+    int64_t timestamp = now_ns();
+    if (mEventFd >= 0) {
+        const int64_t offset = mEventsMonotonic ? 0 : getRealtimeOffset();
+        struct iio_event_data event;
+        while (read(mEventFd, &event, sizeof(event)) == sizeof(event)) {
+            int dir = IIO_EVENT_CODE_EXTRACT_DIR(event.id);
+            if (dir == IIO_EV_DIR_RISING)
+                near = true;
+            else if (dir == IIO_EV_DIR_FALLING)
+                near = false;
+            else
+                continue;
+            // when the crossing happened rather than when it was read
+            if (event.timestamp)
+                timestamp = event.timestamp - offset;
+        }
+    } else {
+        near = readNear();
+    }
 
-    if (amt <= 0 && mAlready_warned == false) {
-        ALOGE("ProximitySensor: read from %s failed", PROX_SYSFS_PATH);
-    mAlready_warned = true;
+    if (near == mNear && !mHasPendingEvent)
         return 0;
+    mHasPendingEvent = false;
+    if (near != mNear) {
+        mNear = near;
+        if (mEventFd >= 0 && armThreshold() < 0) {
+            ALOGE("ProximitySensor: couldn't rearm, sampling instead");
+            closeEvents();
+            set_timer(delay_time);
+        }
     }
-    value = atof(buffer);
-    if (value == mLast_value)
-       return 0;
+
     (*data).version = sizeof(sensors_event_t);
     (*data).sensor = ID_P;
     (*data).type = SENSOR_TYPE_PROXIMITY;
-    (*data).distance =  value > 5000 ? 0 : 1; /* 0 = near; 1 = far. Based on how android expects */
-    (*data).timestamp = now_ns();
-    mLast_value = value;
-    ALOGD("ProximitySensor: value is %i", (int)value );
+    (*data).distance = mNear ? 0 : 1; /* 0 = near; 1 = far. Based on how android expects */
+    (*data).timestamp = timestamp;
+    ALOGD("ProximitySensor: %s", mNear ? "near" : "far");
     return 1;
 }
 
 int ProximitySensor::getFd() const {
-    return -1;
+    return mEventFd;
 }
@@ -24,11 +24,29 @@
 
 struct input_event;
 
+/*
+ * Reports near/far, with hysteresis between the two thresholds. When the
+ * IIO driver supports threshold events the sensor is not sampled at all:
+ * the reader thread sleeps on the event fd until the state flips, and
+ * only the threshold leading out of the current state is armed.
+ */
 class ProximitySensor : public SensorBase {
     int mEnabled;
     bool mHasPendingEvent;
-    bool mAlready_warned;
-    float mLast_value;
+    bool mNear;
+    int mEventFd;
+    // whether the threshold events are stamped with CLOCK_MONOTONIC
+    bool mEventsMonotonic;
+    SysfsAttribute mProx;
+    SysfsAttribute mRisingValue;
+    SysfsAttribute mRisingEnable;
+    SysfsAttribute mFallingValue;
+    SysfsAttribute mFallingEnable;
+
+    int openEvents();
+    void closeEvents();
+    int armThreshold();
+    bool readNear();
 
 public:
             ProximitySensor();
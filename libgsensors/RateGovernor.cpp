@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "RateGovernor.h"
+
+/*****************************************************************************/
+
+#define WINDOW_NS			500000000LL
+/* periods of backlog above which the rate goes down, at or below which up */
+#define SLOWER_LAG_PERIODS	8
+#define FASTER_LAG_PERIODS	2
+/* windows left alone after a step, for the consumer to settle */
+#define HOLD_WINDOWS		2
+
+RateGovernor::RateGovernor() :
+	mMaxThrottle(0) {
+	reset();
+}
+
+void RateGovernor::setMaxThrottle(int maxThrottle) {
+	mMaxThrottle = maxThrottle;
+	if (mThrottle > mMaxThrottle)
+		mThrottle = mMaxThrottle;
+}
+
+void RateGovernor::reset() {
+	mThrottle = 0;
+	mHold = HOLD_WINDOWS;
+	mWindowStart = -1;
+	mMaxLag = 0;
+}
+
+bool RateGovernor::update(int64_t lag, int64_t period, int64_t now) {
+	if (lag < 0) {
+		// batched or direct, whatever the consumer does is on purpose
+		const bool changed = mThrottle != 0;
+		reset();
+		return changed;
+	}
+	if (mWindowStart < 0)
+		mWindowStart = now;
+	if (lag > mMaxLag)
+		mMaxLag = lag;
+	if (now - mWindowStart < WINDOW_NS)
+		return false;
+
+	const int64_t windowLag = mMaxLag;
+	mWindowStart = now;
+	mMaxLag = 0;
+
+	if (period <= 0)
+		return false;
+	if (mHold > 0) {
+		mHold--;
+		return false;
+	}
+	int throttle = mThrottle;
+	if (windowLag > SLOWER_LAG_PERIODS * period)
+		throttle++;
+	else if (windowLag <= FASTER_LAG_PERIODS * period)
+		throttle--;
+	if (throttle < 0 || throttle > mMaxThrottle || throttle == mThrottle)
+		return false;
+	mThrottle = throttle;
+	mHold = HOLD_WINDOWS;
+	return true;
+}
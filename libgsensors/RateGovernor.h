@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_RATE_GOVERNOR_H
+#define ANDROID_RATE_GOVERNOR_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Throttles the output data rate of a sensor to what its consumer takes.
+ * The consumer the HAL sees is whoever calls poll(): over each window
+ * the governor keeps the longest a sample waited in the event queue before
+ * poll() handed it out. Samples piling up for many periods get the rate
+ * halved; a consumer taking them within a couple of periods gets it
+ * doubled back. The band between the two thresholds and the windows held
+ * after every step keep it from hunting. Consumers which batch or read
+ * a direct channel are not meant to keep up, and get the full rate.
+ */
+class RateGovernor {
+	int mThrottle;
+	int mMaxThrottle;
+	int mHold;
+	int64_t mWindowStart;
+	int64_t mMaxLag;
+
+public:
+	RateGovernor();
+
+	/* how many times the rate may be halved */
+	void setMaxThrottle(int maxThrottle);
+	/* back to the requested rate, e.g. on a new request */
+	void reset();
+	/*
+	 * how long the last samples waited to be handed out, -1 if the
+	 * consumer batches, and the sampling period; returns true when the
+	 * throttle changed
+	 */
+	bool update(int64_t lag, int64_t period, int64_t now);
+	/* how many times the requested rate is to be halved */
+	int getThrottle() const { return mThrottle; }
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_RATE_GOVERNOR_H
@@ -19,18 +19,27 @@
 #include <math.h>
 #include <poll.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <sys/epoll.h>
 #include <sys/select.h>
+#include <sys/timerfd.h>
 #include <cutils/log.h>
 #include <linux/input.h>
 
 #include "SensorBase.h"
+#include "InputDeviceIndex.h"
 
 /*****************************************************************************/
 
+#ifndef EVIOCSCLOCKID
+#define EVIOCSCLOCKID		_IOW('E', 0xa0, int)
+#endif
+
+/* shortest period a timer driven sensor is sampled at */
+#define MIN_TIMER_PERIOD	10000000LL
+
 SensorBase::SensorBase(const char* dev_name, const char* data_name) :
 	dev_name(dev_name), data_name(data_name), dev_fd(-1), data_fd(-1),
-			mEnabled(false) {
+			timer_fd(-1), mEnabled(false), input_realtime(false), stats(NULL) {
 	if (data_name) {
 		data_fd = openInput(data_name);
 	}
@@ -43,6 +52,9 @@ SensorBase::~SensorBase() {
 	if (dev_fd >= 0) {
 		close( dev_fd);
 	}
+	if (timer_fd >= 0) {
+		close( timer_fd);
+	}
 }
 
 int SensorBase::open_device() {
@@ -61,6 +73,50 @@ int SensorBase::close_device() {
 	return 0;
 }
 
+int SensorBase::open_timer() {
+	if (timer_fd < 0) {
+		timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		ALOGE_IF(timer_fd < 0, "Couldn't create timerfd (%s)", strerror(errno));
+	}
+	return timer_fd < 0 ? -errno : 0;
+}
+
+int SensorBase::set_timer(int64_t period_ns) {
+	struct itimerspec spec;
+
+	if (timer_fd < 0)
+		return -EBADF;
+
+	memset(&spec, 0, sizeof(spec));
+	if (period_ns > 0) {
+		if (period_ns < MIN_TIMER_PERIOD)
+			period_ns = MIN_TIMER_PERIOD;
+		spec.it_interval.tv_sec = period_ns / 1000000000LL;
+		spec.it_interval.tv_nsec = period_ns % 1000000000LL;
+		/* first sample is taken right away, then once per period */
+		spec.it_value.tv_nsec = 1;
+	}
+	if (timerfd_settime(timer_fd, 0, &spec, NULL) < 0) {
+		ALOGE("timerfd_settime failed (%s)", strerror(errno));
+		return -errno;
+	}
+	return 0;
+}
+
+int SensorBase::getTimerFd() const {
+	return timer_fd;
+}
+
+int SensorBase::readTimer() {
+	uint64_t expirations = 0;
+
+	if (timer_fd < 0)
+		return 0;
+	if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+		return 0;
+	return expirations > 0 ? 1 : 0;
+}
+
 int SensorBase::getFd() const {
 	if (!data_name) {
 		return dev_fd;
@@ -68,6 +124,10 @@ int SensorBase::getFd() const {
 	return data_fd;
 }
 
+uint32_t SensorBase::getFdEvents() const {
+	return EPOLLIN;
+}
+
 int SensorBase::setDelay(int32_t handle, int64_t ns) {
 	return 0;
 }
@@ -88,39 +148,35 @@ int64_t SensorBase::getTimestamp() {
 }
 
 int SensorBase::openInput(const char* inputName) {
-	int fd = -1;
-	const char *dirname = "/dev/input";
-	char devname[PATH_MAX];
-	char *filename;
-	DIR *dir;
-	struct dirent *de;
-	dir = opendir(dirname);
-	if (dir == NULL)
-		return -1;
-	strcpy(devname, dirname);
-	filename = devname + strlen(devname);
-	*filename++ = '/';
-	while ((de = readdir(dir))) {
-		if (de->d_name[0] == '.' && (de->d_name[1] == '\0' || (de->d_name[1]
-				== '.' && de->d_name[2] == '\0')))
-			continue;
-		strcpy(filename, de->d_name);
-		fd = open(devname, O_RDONLY);
-		if (fd >= 0) {
-			char name[80];
-			if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), &name) < 1) {
-				name[0] = '\0';
-			}
-			if (!strcmp(name, inputName)) {
-				strcpy(input_name, filename);
-				break;
-			} else {
-				close(fd);
-				fd = -1;
-			}
-		}
-	}
-	closedir(dir);
+	int fd = InputDeviceIndex::getInstance().open(inputName, input_name,
+			sizeof(input_name));
 	ALOGE_IF(fd < 0, "couldn't find '%s' input device", inputName);
+	if (fd >= 0) {
+		// evdev stamps with CLOCK_REALTIME unless told otherwise, which
+		// jumps with the wall clock and differs from all other sensors
+		int clock = CLOCK_MONOTONIC;
+		input_realtime = ioctl(fd, EVIOCSCLOCKID, &clock) < 0;
+		ALOGW_IF(input_realtime, "couldn't set the clock of %s (%s)",
+				input_name, strerror(errno));
+	}
 	return fd;
 }
+
+int64_t SensorBase::getRealtimeOffset() {
+	struct timespec mono, real;
+	clock_gettime(CLOCK_MONOTONIC, &mono);
+	clock_gettime(CLOCK_REALTIME, &real);
+	return (int64_t(real.tv_sec) - mono.tv_sec) * 1000000000LL
+			+ (real.tv_nsec - mono.tv_nsec);
+}
+
+int SensorBase::hotplug() {
+	return 0;
+}
+
+void SensorBase::setConsumerLag(int64_t lag) {
+}
+
+void SensorBase::setStats(SensorStats* stats) {
+	this->stats = stats;
+}
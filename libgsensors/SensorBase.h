@@ -22,9 +22,12 @@
 #include <sys/cdefs.h>
 #include <sys/types.h>
 
+#include "SysfsAttribute.h"
+
 /*****************************************************************************/
 
 struct sensors_event_t;
+class SensorStats;
 
 class SensorBase {
 protected:
@@ -33,11 +36,18 @@ protected:
 	char input_name[PATH_MAX];
 	int dev_fd;
 	int data_fd;
+	int timer_fd;
 	bool mEnabled;
 	int64_t delay_time;
+	// set when the input device could not be switched to CLOCK_MONOTONIC
+	bool input_realtime;
+	// where drivers count what the kernel dropped, may be NULL
+	SensorStats* stats;
 
 	int openInput(const char* inputName);
 	static int64_t getTimestamp();
+	/* CLOCK_REALTIME - CLOCK_MONOTONIC, to rebase stamps of input_realtime */
+	static int64_t getRealtimeOffset();
 
 	static int64_t timevalToNano(timeval const& t) {
 		return t.tv_sec*1000000000LL + t.tv_usec*1000;
@@ -46,6 +56,14 @@ protected:
 	int open_device();
 	int close_device();
 
+	/*
+	 * Periodic sampling for drivers that have no event source of
+	 * their own: open_timer() creates a timerfd, set_timer() arms it
+	 * to expire every period_ns (0 disarms it).
+	 */
+	int open_timer();
+	int set_timer(int64_t period_ns);
+
 public:
 	SensorBase(const char* dev_name, const char* data_name);
 	virtual ~SensorBase();
@@ -53,9 +71,26 @@ public:
 	virtual int readEvents(sensors_event_t* data, int count) = 0;
 	virtual bool hasPendingEvents() const;
 	virtual int getFd() const;
+	/* epoll events telling that getFd() has data */
+	virtual uint32_t getFdEvents() const;
+	int getTimerFd() const;
+	int readTimer();
 	virtual int setDelay(int32_t handle, int64_t ns);
 	virtual int64_t getDelay() const;
 	virtual int enable(int32_t handle, int enabled) = 0;
+	/*
+	 * Called after /dev/input changed. Drivers whose device was
+	 * missing try to open it again; returns 1 if getFd() changed.
+	 */
+	virtual int hotplug();
+	/*
+	 * Called before each read with how long the events of this driver
+	 * last waited to be handed out by poll(), -1 when a consumer of the
+	 * driver batches or reads through a direct channel. For drivers
+	 * which adapt their rate to how fast their consumer drains them.
+	 */
+	virtual void setConsumerLag(int64_t lag);
+	void setStats(SensorStats* stats);
 };
 
 /*****************************************************************************/
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cutils/atomic.h>
+#include <cutils/log.h>
+
+#include "SensorEventQueue.h"
+
+/*****************************************************************************/
+
+extern int64_t now_ns(void);
+
+uint32_t SensorEventQueue::roundUp(size_t numEvents) {
+	uint32_t size = 2;
+	while (size < numEvents)
+		size <<= 1;
+	return size;
+}
+
+SensorEventQueue::SensorEventQueue(size_t numEvents) :
+	mSlots(new Slot[roundUp(numEvents)]), mMask(roundUp(numEvents) - 1),
+	mTail(0), mHead(0) {
+	for (uint32_t i = 0; i <= mMask; i++) {
+		mSlots[i].seq = i;
+	}
+}
+
+SensorEventQueue::~SensorEventQueue() {
+	delete [] mSlots;
+}
+
+int SensorEventQueue::write(sensors_event_t const* events, int count) {
+	const int64_t now = now_ns();
+	int written = 0;
+
+	while (written < count) {
+		uint32_t pos = android_atomic_acquire_load(&mTail);
+		Slot* slot;
+		for (;;) {
+			slot = &mSlots[pos & mMask];
+			int32_t diff = int32_t(uint32_t(
+					android_atomic_acquire_load(&slot->seq)) - pos);
+			if (diff == 0) {
+				// free slot, try to claim its position
+				if (android_atomic_release_cas(pos, pos + 1, &mTail) == 0)
+					break;
+			} else if (diff < 0) {
+				// the consumer has not released this slot yet: full
+				return written;
+			}
+			pos = android_atomic_acquire_load(&mTail);
+		}
+		slot->event = events[written++];
+		slot->queued = now;
+		android_atomic_release_store(pos + 1, &slot->seq);
+	}
+	return written;
+}
+
+int SensorEventQueue::read(sensors_event_t* data, int count,
+		int64_t* queued) {
+	int nb = 0;
+
+	while (nb < count) {
+		Slot* slot = &mSlots[mHead & mMask];
+		int32_t diff = int32_t(uint32_t(
+				android_atomic_acquire_load(&slot->seq)) - (mHead + 1));
+		if (diff < 0)
+			break;
+		if (queued)
+			queued[nb] = slot->queued;
+		data[nb++] = slot->event;
+		android_atomic_release_store(mHead + mMask + 1, &slot->seq);
+		mHead++;
+	}
+	return nb;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_EVENT_QUEUE_H
+#define ANDROID_SENSOR_EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+
+/*****************************************************************************/
+
+/*
+ * Bounded lock-free queue of sensors_event_t with any number of
+ * producers and a single consumer. Every slot carries a sequence number
+ * telling whether it is free for the producer which claimed that
+ * position or holds an event for the consumer, so neither side ever
+ * blocks. The size is rounded up to a power of two.
+ */
+class SensorEventQueue {
+	struct Slot {
+		volatile int32_t seq;
+		sensors_event_t event;
+		// when the producer wrote it
+		int64_t queued;
+	};
+
+	Slot* const mSlots;
+	const uint32_t mMask;
+	volatile int32_t mTail;
+	uint32_t mHead;
+
+	static uint32_t roundUp(size_t numEvents);
+
+public:
+	SensorEventQueue(size_t numEvents);
+	~SensorEventQueue();
+
+	/* producers: returns how many events were queued, the rest is lost */
+	int write(sensors_event_t const* events, int count);
+	/* consumer only, with when each event was written if queued is set */
+	int read(sensors_event_t* data, int count, int64_t* queued = NULL);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_EVENT_QUEUE_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <cutils/log.h>
+
+#include "SensorFifo.h"
+
+/*****************************************************************************/
+
+SensorFifo::SensorFifo(int handle, size_t numEvents) :
+	mBuffer(numEvents ? new sensors_event_t[numEvents] : NULL),
+	mSize(numEvents), mHandle(handle), mHead(0), mCount(0), mTimeout(0),
+	mFirstArrival(0), mDraining(false), mFlushes(0) {
+}
+
+SensorFifo::SensorFifo(int handle, size_t numEvents, bool store) :
+	mBuffer(numEvents && store ? new sensors_event_t[numEvents] : NULL),
+	mSize(numEvents), mHandle(handle), mHead(0), mCount(0), mTimeout(0),
+	mFirstArrival(0), mDraining(false), mFlushes(0) {
+}
+
+SensorFifo::~SensorFifo() {
+	delete [] mBuffer;
+}
+
+void SensorFifo::setTimeout(int64_t ns) {
+	mTimeout = mSize ? ns : 0;
+}
+
+bool SensorFifo::isBatching() const {
+	return mTimeout > 0;
+}
+
+size_t SensorFifo::getCount() const {
+	return mCount;
+}
+
+int64_t SensorFifo::getDeadline() const {
+	if (mFlushes || mDraining || (mCount && !isBatching()))
+		return 0;
+	if (!mCount)
+		return -1;
+	return mFirstArrival + mTimeout;
+}
+
+bool SensorFifo::isReady(int64_t now) const {
+	int64_t deadline = getDeadline();
+	if (deadline < 0)
+		return false;
+	return isFull() || now >= deadline;
+}
+
+bool SensorFifo::isFull() const {
+	return mCount == mSize;
+}
+
+void SensorFifo::append(sensors_event_t const& event) {
+	mBuffer[(mHead + mCount) % mSize] = event;
+}
+
+void SensorFifo::removeOldest(sensors_event_t* event) {
+	if (event)
+		*event = mBuffer[mHead];
+	mHead = (mHead + 1) % mSize;
+}
+
+void SensorFifo::removeAll() {
+	mHead = 0;
+}
+
+int SensorFifo::push(sensors_event_t const& event, int64_t now) {
+	int dropped = 0;
+
+	if (!mSize)
+		return 1;
+	if (!mCount)
+		mFirstArrival = now;
+	while (mCount && isFull()) {
+		// the framework did not drain us in time, lose the oldest event
+		removeOldest(NULL);
+		mCount--;
+		dropped++;
+	}
+	append(event);
+	mCount++;
+	return dropped;
+}
+
+void SensorFifo::flush() {
+	mFlushes++;
+}
+
+void SensorFifo::clear() {
+	removeAll();
+	mCount = 0;
+	mDraining = false;
+}
+
+int SensorFifo::drain(sensors_event_t* data, int count, int64_t now) {
+	int nb = 0;
+
+	if (!isReady(now))
+		return 0;
+
+	// once started, the whole batch goes out even if it takes several polls
+	mDraining = true;
+	while (nb < count && mCount) {
+		removeOldest(&data[nb++]);
+		mCount--;
+	}
+	if (mCount)
+		return nb;
+	mDraining = false;
+
+	while (nb < count && mFlushes) {
+		sensors_event_t* meta = &data[nb++];
+		memset(meta, 0, sizeof(*meta));
+		meta->version = META_DATA_VERSION;
+		meta->type = SENSOR_TYPE_META_DATA;
+		meta->meta_data.what = META_DATA_FLUSH_COMPLETE;
+		meta->meta_data.sensor = mHandle;
+		mFlushes--;
+	}
+	return nb;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_FIFO_H
+#define ANDROID_SENSOR_FIFO_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+
+/*****************************************************************************/
+
+/*
+ * Bounded batch FIFO of one sensor handle. Events are held until the
+ * max report latency set with setTimeout() expires for the oldest of
+ * them, the FIFO fills up or a flush is requested, and are then drained
+ * in one go followed by any flush complete events owed to the framework.
+ * The events are kept as they are, subclasses may store them their own
+ * way by overriding the storage methods.
+ */
+class SensorFifo {
+	sensors_event_t* const mBuffer;
+	const size_t mSize;
+	const int mHandle;
+	size_t mHead;
+	size_t mCount;
+	int64_t mTimeout;
+	int64_t mFirstArrival;
+	bool mDraining;
+	int mFlushes;
+
+protected:
+	/* store is false for subclasses that keep the events themselves */
+	SensorFifo(int handle, size_t numEvents, bool store);
+
+	/* storage of the events, the count is kept by the caller */
+	virtual bool isFull() const;
+	virtual void append(sensors_event_t const& event);
+	/* takes the oldest event out, event may be NULL to drop it */
+	virtual void removeOldest(sensors_event_t* event);
+	virtual void removeAll();
+
+public:
+	SensorFifo(int handle, size_t numEvents);
+	virtual ~SensorFifo();
+
+	void setTimeout(int64_t ns);
+	bool isBatching() const;
+	size_t getCount() const;
+	int64_t getDeadline() const;
+	bool isReady(int64_t now) const;
+
+	int push(sensors_event_t const& event, int64_t now);
+	void flush();
+	void clear();
+	int drain(sensors_event_t* data, int count, int64_t now);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_FIFO_H
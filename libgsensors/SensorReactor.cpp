@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <cutils/log.h>
+
+#include "SensorReactor.h"
+
+/*****************************************************************************/
+
+SensorReactor::SensorReactor() {
+	mEpollFd = epoll_create(8);
+	ALOGE_IF(mEpollFd < 0, "error creating epoll fd (%s)", strerror(errno));
+	mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ALOGE_IF(mWakeFd < 0, "error creating wake eventfd (%s)", strerror(errno));
+	addFd(mWakeFd, EPOLLIN, WAKE);
+}
+
+SensorReactor::~SensorReactor() {
+	if (mWakeFd >= 0)
+		close(mWakeFd);
+	if (mEpollFd >= 0)
+		close(mEpollFd);
+}
+
+int SensorReactor::addFd(int fd, uint32_t events, uint32_t tag) {
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.u32 = tag;
+	if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		ALOGE("error adding fd %d to epoll set (%s)", fd, strerror(errno));
+		return -errno;
+	}
+	return 0;
+}
+
+int SensorReactor::removeFd(int fd) {
+	// a closed fd has already left the set on its own
+	if (epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, NULL) < 0)
+		return -errno;
+	return 0;
+}
+
+int SensorReactor::wait(struct epoll_event* events, int maxEvents,
+		int timeout) {
+	int n = epoll_wait(mEpollFd, events, maxEvents, timeout);
+	if (n < 0)
+		return -errno;
+
+	for (int i = 0; i < n; i++) {
+		if (events[i].data.u32 == WAKE) {
+			uint64_t count;
+			read(mWakeFd, &count, sizeof(count));
+		}
+	}
+	return n;
+}
+
+int SensorReactor::wake() {
+	uint64_t one = 1;
+	if (write(mWakeFd, &one, sizeof(one)) != sizeof(one)) {
+		ALOGE("error sending wake event (%s)", strerror(errno));
+		return -errno;
+	}
+	return 0;
+}
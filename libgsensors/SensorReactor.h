@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_REACTOR_H
+#define ANDROID_SENSOR_REACTOR_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <sys/cdefs.h>
+#include <sys/epoll.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * epoll set with an eventfd wake source. Fds can be added and removed
+ * at any time, also while another thread sits in wait(). Any number of
+ * wake() calls before the next wait() collapse into a single wakeup,
+ * which wait() reports with the WAKE tag after resetting the eventfd.
+ */
+class SensorReactor {
+	int mEpollFd;
+	int mWakeFd;
+
+public:
+	enum {
+		WAKE = 0xffffffff,
+	};
+
+	SensorReactor();
+	~SensorReactor();
+
+	int addFd(int fd, uint32_t events, uint32_t tag);
+	int removeFd(int fd);
+	int wait(struct epoll_event* events, int maxEvents, int timeout);
+	int wake();
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_REACTOR_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cutils/atomic.h>
+#include <cutils/log.h>
+
+#include "SensorStats.h"
+
+/*****************************************************************************/
+
+static int64_t clockNs(clockid_t clock) {
+	struct timespec t;
+	clock_gettime(clock, &t);
+	return int64_t(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
+SensorStats::SensorStats() :
+	mPolls(0), mWakeups(0) {
+	memset(mCounters, 0, sizeof(mCounters));
+}
+
+int SensorStats::bucketOf(int64_t latency) {
+	uint32_t us = latency > 0 ? uint32_t(latency / 1000) : 0;
+	if (us < 2)
+		return 0;
+	int bucket = 31 - __builtin_clz(us);
+	return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+}
+
+void SensorStats::recordDelivery(sensors_event_t const* data, int count) {
+	if (count <= 0)
+		return;
+
+	// every driver stamps its events with CLOCK_MONOTONIC
+	const int64_t now = clockNs(CLOCK_MONOTONIC);
+
+	for (int i = 0; i < count; i++) {
+		if (data[i].type == SENSOR_TYPE_META_DATA)
+			continue;
+		uint32_t handle = data[i].sensor;
+		if (handle >= MAX_HANDLES)
+			continue;
+		int64_t latency = now - data[i].timestamp;
+		Counters& c = mCounters[handle];
+		c.delivered++;
+		c.buckets[bucketOf(latency)]++;
+	}
+}
+
+void SensorStats::recordDrop(int handle, int count) {
+	if (handle >= 0 && handle < MAX_HANDLES)
+		android_atomic_add(count, &mCounters[handle].dropped);
+}
+
+void SensorStats::recordOverrun(int handle, int count) {
+	if (handle >= 0 && handle < MAX_HANDLES)
+		android_atomic_add(count, &mCounters[handle].overruns);
+}
+
+void SensorStats::recordPoll(bool wakeup) {
+	mPolls++;
+	if (wakeup)
+		mWakeups++;
+}
+
+/* upper bound in microseconds of the bucket holding the percentile */
+int64_t SensorStats::percentile(Counters const& c, uint32_t total,
+		int percent) {
+	uint64_t target = (uint64_t(total) * percent + 99) / 100;
+	uint64_t seen = 0;
+
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		seen += c.buckets[i];
+		if (seen >= target)
+			return 2LL << i;
+	}
+	return 2LL << (NUM_BUCKETS - 1);
+}
+
+void SensorStats::dump(int fd, struct sensor_t const* list, int count) const {
+	char line[256];
+	int len;
+
+	len = snprintf(line, sizeof(line), "polls %u, wakeups %u\n"
+			"%-40s %10s %8s %8s %9s %9s\n", mPolls, mWakeups, "sensor",
+			"delivered", "dropped", "overruns", "p50(us)", "p99(us)");
+	write(fd, line, len);
+
+	for (int i = 0; i < count; i++) {
+		int handle = list[i].handle;
+		if (handle < 0 || handle >= MAX_HANDLES)
+			continue;
+		Counters const& c = mCounters[handle];
+		int32_t dropped = android_atomic_acquire_load(&c.dropped);
+		int32_t overruns = android_atomic_acquire_load(&c.overruns);
+		if (c.delivered) {
+			len = snprintf(line, sizeof(line),
+					"%-40s %10u %8d %8d %9lld %9lld\n", list[i].name,
+					c.delivered, dropped, overruns,
+					(long long) percentile(c, c.delivered, 50),
+					(long long) percentile(c, c.delivered, 99));
+		} else {
+			len = snprintf(line, sizeof(line), "%-40s %10u %8d %8d %9s %9s\n",
+					list[i].name, c.delivered, dropped, overruns, "-", "-");
+		}
+		write(fd, line, len);
+	}
+}
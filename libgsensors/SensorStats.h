@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_STATS_H
+#define ANDROID_SENSOR_STATS_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+
+/*****************************************************************************/
+
+/*
+ * Delivery statistics of the HAL. Latency is measured from the event
+ * timestamp to the return of poll() and kept as a power-of-two
+ * histogram per handle. Everything but the drop and overrun counters
+ * is only touched by the poll thread; those are counted atomically from
+ * the reader threads. Overruns are events the kernel itself dropped,
+ * e.g. an evdev buffer that filled up (SYN_DROPPED).
+ */
+class SensorStats {
+public:
+	enum {
+		MAX_HANDLES = 32,
+		// bucket i holds latencies below 2^(i+1) microseconds
+		NUM_BUCKETS = 20,
+	};
+
+private:
+	struct Counters {
+		uint32_t delivered;
+		volatile int32_t dropped;
+		volatile int32_t overruns;
+		uint32_t buckets[NUM_BUCKETS];
+	};
+
+	Counters mCounters[MAX_HANDLES];
+	uint32_t mPolls;
+	uint32_t mWakeups;
+
+	static int bucketOf(int64_t latency);
+	static int64_t percentile(Counters const& c, uint32_t total, int percent);
+
+public:
+	SensorStats();
+
+	void recordDelivery(sensors_event_t const* data, int count);
+	void recordDrop(int handle, int count);
+	void recordOverrun(int handle, int count);
+	void recordPoll(bool wakeup);
+
+	/* writes a text report, one line per handle in list */
+	void dump(int fd, struct sensor_t const* list, int count) const;
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_STATS_H
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <cutils/atomic.h>
+#include <cutils/log.h>
+
+#include "SensorThread.h"
+
+/*****************************************************************************/
+
+#define NUM_READ_EVENTS		32
+
+enum {
+	DATA, TIMER,
+};
+
+SensorThread::SensorThread(SensorBase* sensor, SensorEventQueue* queue,
+		SensorReactor* pollReactor, SensorStats* stats,
+		volatile int32_t const* consumerLag) :
+	mSensor(sensor), mQueue(queue), mPollReactor(pollReactor), mStats(stats),
+			mConsumerLag(consumerLag), mDataFd(-1), mStarted(false), mExitPending(0),
+			mHotplugPending(0), mNumChannels(0) {
+	pthread_mutex_init(&mLock, NULL);
+	pthread_mutex_init(&mSensorLock, NULL);
+	memset(mChannels, 0, sizeof(mChannels));
+	mSensor->setStats(mStats);
+	if (mSensor->getTimerFd() >= 0)
+		mReactor.addFd(mSensor->getTimerFd(), EPOLLIN, TIMER);
+	update();
+}
+
+SensorThread::~SensorThread() {
+	if (mStarted) {
+		android_atomic_release_store(1, &mExitPending);
+		mReactor.wake();
+		pthread_join(mThread, NULL);
+	}
+	pthread_mutex_destroy(&mLock);
+	pthread_mutex_destroy(&mSensorLock);
+}
+
+int SensorThread::start() {
+	int err = pthread_create(&mThread, NULL, threadLoop, this);
+	if (err) {
+		ALOGE("error creating sensor thread (%s)", strerror(err));
+		return -err;
+	}
+	mStarted = true;
+	return 0;
+}
+
+void SensorThread::lock() {
+	pthread_mutex_lock(&mSensorLock);
+}
+
+void SensorThread::unlock() {
+	pthread_mutex_unlock(&mSensorLock);
+}
+
+void SensorThread::update() {
+	pthread_mutex_lock(&mLock);
+	// re-register even an unchanged fd number: enable() may have closed
+	// the old file, which silently dropped it from the epoll set
+	if (mDataFd >= 0)
+		mReactor.removeFd(mDataFd);
+	mDataFd = mSensor->getFd();
+	if (mDataFd >= 0)
+		mReactor.addFd(mDataFd, mSensor->getFdEvents(), DATA);
+	pthread_mutex_unlock(&mLock);
+	mReactor.wake();
+}
+
+void SensorThread::hotplug() {
+	android_atomic_release_store(1, &mHotplugPending);
+	mReactor.wake();
+}
+
+void SensorThread::setChannel(int handle, DirectChannel* channel) {
+	pthread_mutex_lock(&mLock);
+	if (mChannels[handle])
+		mNumChannels--;
+	mChannels[handle] = channel;
+	if (channel)
+		mNumChannels++;
+	pthread_mutex_unlock(&mLock);
+}
+
+void SensorThread::writeChannels(sensors_event_t const* events, int count) {
+	pthread_mutex_lock(&mLock);
+	for (int i = 0; mNumChannels && i < count; i++) {
+		DirectChannel* channel = mChannels[events[i].sensor];
+		if (channel)
+			channel->write(&events[i], 1);
+	}
+	pthread_mutex_unlock(&mLock);
+}
+
+void* SensorThread::threadLoop(void* arg) {
+	static_cast<SensorThread*> (arg)->loop();
+	return NULL;
+}
+
+void SensorThread::loop() {
+	struct epoll_event events[4];
+	sensors_event_t buffer[NUM_READ_EVENTS];
+
+	while (!android_atomic_acquire_load(&mExitPending)) {
+		int n = mReactor.wait(events, ARRAY_SIZE(events),
+				mSensor->hasPendingEvents() ? 0 : -1);
+		if (n < 0) {
+			if (n == -EINTR)
+				continue;
+			ALOGE("epoll_wait() failed (%s)", strerror(-n));
+			break;
+		}
+
+		// done here so the driver fd only ever changes on this thread
+		lock();
+		if (android_atomic_cmpxchg(1, 0, &mHotplugPending) == 0) {
+			if (mSensor->hotplug() > 0)
+				update();
+		}
+
+		bool ready = mSensor->hasPendingEvents();
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.u32 == DATA) {
+				ready = true;
+			} else if (events[i].data.u32 == TIMER) {
+				// the sampling period of this driver has elapsed
+				mSensor->readTimer();
+				ready = true;
+			}
+		}
+		if (!ready) {
+			unlock();
+			continue;
+		}
+
+		const int32_t lag = android_atomic_acquire_load(mConsumerLag);
+		mSensor->setConsumerLag(lag < 0 ? -1 : lag * 1000LL);
+		int nb = mSensor->readEvents(buffer, NUM_READ_EVENTS);
+		unlock();
+		if (nb == -ENODEV) {
+			// the driver closed its device, stop polling the dead fd
+			update();
+			continue;
+		}
+		if (nb <= 0)
+			continue;
+		// direct consumers get the events straight from this thread
+		writeChannels(buffer, nb);
+		int queued = mQueue->write(buffer, nb);
+		if (queued < nb) {
+			ALOGW("event queue full, dropped %d events", nb - queued);
+			for (int i = queued; i < nb; i++)
+				mStats->recordDrop(buffer[i].sensor, 1);
+		}
+		mPollReactor->wake();
+	}
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_THREAD_H
+#define ANDROID_SENSOR_THREAD_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+#include "SensorBase.h"
+#include "SensorEventQueue.h"
+#include "SensorReactor.h"
+#include "SensorStats.h"
+#include "DirectChannel.h"
+
+/*****************************************************************************/
+
+/*
+ * Reader thread of one driver. It waits on the driver fd and sampling
+ * timer, reads the driver and pushes the events into the shared queue,
+ * then wakes the poll thread through its reactor. A slow driver
+ * therefore only ever delays its own events.
+ */
+class SensorThread {
+	SensorBase* const mSensor;
+	SensorEventQueue* const mQueue;
+	SensorReactor* const mPollReactor;
+	SensorStats* const mStats;
+	// microseconds, published by the poll thread, see setConsumerLag()
+	volatile int32_t const* const mConsumerLag;
+	SensorReactor mReactor;
+	pthread_mutex_t mLock;
+	// serializes the calls into the driver, see lock()
+	pthread_mutex_t mSensorLock;
+	int mDataFd;
+	pthread_t mThread;
+	bool mStarted;
+	volatile int32_t mExitPending;
+	volatile int32_t mHotplugPending;
+	// shared memory rings by handle, guarded by mLock
+	DirectChannel* mChannels[SensorStats::MAX_HANDLES];
+	int mNumChannels;
+
+	static void* threadLoop(void* arg);
+	void loop();
+	void writeChannels(sensors_event_t const* events, int count);
+
+public:
+	SensorThread(SensorBase* sensor, SensorEventQueue* queue,
+			SensorReactor* pollReactor, SensorStats* stats,
+			volatile int32_t const* consumerLag);
+	~SensorThread();
+
+	int start();
+	/*
+	 * held by this thread while it reads the driver; other threads
+	 * take it around enable(), setDelay() and any other driver call
+	 */
+	void lock();
+	void unlock();
+	/* makes the thread pick up a new driver fd, e.g. after enable() */
+	void update();
+	/* asks the driver to look for its input device again */
+	void hotplug();
+	/* copies the events of handle to channel as well, NULL to stop */
+	void setChannel(int handle, DirectChannel* channel);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_THREAD_H
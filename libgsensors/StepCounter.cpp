@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <cutils/log.h>
+
+#include "AtomicFile.h"
+#include "StepCounter.h"
+
+/*****************************************************************************/
+
+/* steps taken between two writes of the file */
+#define STEPS_PER_SAVE		64
+
+StepCounter::StepCounter(const char* path) :
+	mPath(path), mCount(0), mSaved(0) {
+}
+
+int StepCounter::load() {
+	unsigned long long count;
+
+	FILE* f = fopen(mPath, "r");
+	if (!f)
+		return -errno;
+	int n = fscanf(f, "%llu", &count);
+	fclose(f);
+	if (n != 1) {
+		ALOGE("StepCounter: %s is malformed, ignoring it", mPath);
+		return -EINVAL;
+	}
+	mCount = mSaved = count;
+	return 0;
+}
+
+int StepCounter::save() {
+	char contents[24];
+
+	if (mCount == mSaved)
+		return 0;
+	snprintf(contents, sizeof(contents), "%llu\n",
+			(unsigned long long) mCount);
+	int err = writeFileAtomic(mPath, contents);
+	if (err < 0)
+		return err;
+	mSaved = mCount;
+	return 0;
+}
+
+uint64_t StepCounter::add(int steps) {
+	mCount += steps;
+	if (mCount - mSaved >= STEPS_PER_SAVE)
+		save();
+	return mCount;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_STEP_COUNTER_H
+#define ANDROID_STEP_COUNTER_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Running count of the steps taken while the step counter was active,
+ * kept in a file so that it survives the HAL and the device restarting.
+ * It is written back every so many steps rather than on each one.
+ */
+class StepCounter {
+	const char* const mPath;
+	uint64_t mCount;
+	uint64_t mSaved;
+
+public:
+	StepCounter(const char* path);
+
+	int load();
+	/* writes the count if it changed since it was last loaded or saved */
+	int save();
+
+	uint64_t add(int steps);
+	uint64_t getCount() const { return mCount; }
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_STEP_COUNTER_H
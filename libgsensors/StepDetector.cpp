@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "StepDetector.h"
+
+/*****************************************************************************/
+
+/* fixed point samples are m/s^2 in Q8, clamped to keep squares in 32 bits */
+#define FRACTION_BITS		8
+#define MAX_COMPONENT		(32 << FRACTION_BITS)
+/* the smoothing filter passes the cadence of a walk, up to about 4 Hz */
+#define LOW_PASS_PERIOD		40000000LL
+/* and the mean follows over about 16 times as long */
+#define MEAN_EXTRA_SHIFT	4
+/* swing around the mean that makes a step, in Q8 m/s^2 */
+#define STEP_HIGH			(1 << FRACTION_BITS)
+#define STEP_LOW			(-(1 << FRACTION_BITS) / 2)
+#define MIN_STEP_INTERVAL	250000000LL
+#define MAX_STEP_INTERVAL	2000000000LL
+
+StepDetector::StepDetector() :
+	mLowPassShift(0) {
+	reset();
+}
+
+void StepDetector::setPeriod(int64_t period) {
+	int shift = 0;
+	for (int64_t p = period; p > 0 && p < LOW_PASS_PERIOD; p <<= 1)
+		shift++;
+	mLowPassShift = shift;
+}
+
+void StepDetector::reset() {
+	mSmoothed = 0;
+	mMean = 0;
+	mPrimed = false;
+	mArmed = false;
+	mWalking = false;
+	mLastStep = -1;
+}
+
+uint32_t StepDetector::isqrt(uint32_t v) {
+	uint32_t root = 0;
+	uint32_t bit = 1u << 30;
+
+	while (bit > v)
+		bit >>= 2;
+	while (bit) {
+		if (v >= root + bit) {
+			v -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+int StepDetector::update(float const* v, int64_t timestamp) {
+	uint32_t sum = 0;
+	for (int i = 0; i < 3; i++) {
+		int32_t c = int32_t(v[i] * (1 << FRACTION_BITS));
+		if (c > MAX_COMPONENT)
+			c = MAX_COMPONENT;
+		else if (c < -MAX_COMPONENT)
+			c = -MAX_COMPONENT;
+		sum += uint32_t(c * c);
+	}
+	const int32_t magnitude = int32_t(isqrt(sum));
+
+	if (!mPrimed) {
+		mSmoothed = mMean = magnitude;
+		mPrimed = true;
+		return 0;
+	}
+	mSmoothed += (magnitude - mSmoothed) >> mLowPassShift;
+	mMean += (mSmoothed - mMean) >> (mLowPassShift + MEAN_EXTRA_SHIFT);
+
+	const int32_t swing = mSmoothed - mMean;
+	if (swing < STEP_LOW) {
+		mArmed = true;
+		return 0;
+	}
+	if (!mArmed || swing < STEP_HIGH)
+		return 0;
+	mArmed = false;
+
+	if (mLastStep >= 0 && timestamp - mLastStep < MIN_STEP_INTERVAL)
+		return 0;
+	int steps = 0;
+	if (mLastStep >= 0 && timestamp - mLastStep <= MAX_STEP_INTERVAL) {
+		// the step before this one opened the walk, count it now
+		if (!mWalking)
+			mSteps[steps++] = mLastStep;
+		mSteps[steps++] = timestamp;
+		mWalking = true;
+	} else {
+		mWalking = false;
+	}
+	mLastStep = timestamp;
+	return steps;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_STEP_DETECTOR_H
+#define ANDROID_STEP_DETECTOR_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Finds steps in the accelerometer stream, in fixed point and without
+ * allocating. The magnitude of each sample is smoothed, its slow moving
+ * mean taken off, and a step is a swing from below a low threshold to
+ * above a high one. Swings closer than a quarter second are bounces of
+ * the same step; one coming after a pause of over two seconds only
+ * counts once the next confirms a walk, both steps then being returned.
+ */
+class StepDetector {
+	enum {
+		maxSteps = 2,
+	};
+
+	int mLowPassShift;
+	int32_t mSmoothed;
+	int32_t mMean;
+	bool mPrimed;
+	bool mArmed;
+	bool mWalking;
+	int64_t mLastStep;
+	int64_t mSteps[maxSteps];
+
+	static uint32_t isqrt(uint32_t v);
+
+public:
+	StepDetector();
+
+	/* sampling period, which sets the time constants of the filters */
+	void setPeriod(int64_t period);
+	void reset();
+	/* takes a calibrated sample in m/s^2, returns the steps it ended */
+	int update(float const* v, int64_t timestamp);
+	/* when step i of those the last update() returned was taken */
+	int64_t getStepTimestamp(int i) const { return mSteps[i]; }
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_STEP_DETECTOR_H
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <cutils/log.h>
+
+#include "SysfsAttribute.h"
+
+/*****************************************************************************/
+
+SysfsAttribute::SysfsAttribute(const char* path, int flags) :
+	mPath(path), mFlags(flags), mFd(-1), mWritten(0), mHasWritten(false),
+			mWarned(false) {
+}
+
+SysfsAttribute::~SysfsAttribute() {
+	close();
+}
+
+int SysfsAttribute::open() {
+	if (mFd >= 0)
+		return 0;
+	mFd = ::open(mPath, mFlags | O_CLOEXEC);
+	if (mFd < 0) {
+		ALOGE_IF(!mWarned, "couldn't open %s (%s)", mPath, strerror(errno));
+		mWarned = true;
+		return -errno;
+	}
+	mWarned = false;
+	return 0;
+}
+
+void SysfsAttribute::close() {
+	if (mFd >= 0) {
+		::close(mFd);
+		mFd = -1;
+	}
+	// whatever was written may not survive the attribute going away
+	mHasWritten = false;
+}
+
+/*
+ * Parses "[-]digits[.digits]" into mantissa * 10^-decimals, which is
+ * all sysfs ever hands out and spares a trip through strtod().
+ */
+int SysfsAttribute::readRaw(int64_t* mantissa, int* decimals) {
+	char buffer[24];
+
+	if (mFd < 0 && open() < 0)
+		return -EBADF;
+	ssize_t amt = pread(mFd, buffer, sizeof(buffer) - 1, 0);
+	if (amt <= 0) {
+		ALOGE_IF(!mWarned, "read from %s failed (%s)", mPath,
+				amt < 0 ? strerror(errno) : "empty");
+		mWarned = true;
+		return amt < 0 ? -errno : -ENODATA;
+	}
+	mWarned = false;
+
+	const char* p = buffer;
+	const char* end = buffer + amt;
+	bool negative = false;
+	int64_t m = 0;
+	int d = -1;
+
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	if (p < end && *p == '-') {
+		negative = true;
+		p++;
+	}
+	for (; p < end; p++) {
+		if (*p >= '0' && *p <= '9') {
+			// digits past the ninth decimal are below float precision
+			if (d >= 9)
+				continue;
+			m = m * 10 + (*p - '0');
+			if (d >= 0)
+				d++;
+		} else if (*p == '.' && d < 0) {
+			d = 0;
+		} else {
+			break;
+		}
+	}
+	*mantissa = negative ? -m : m;
+	*decimals = d < 0 ? 0 : d;
+	return 0;
+}
+
+int SysfsAttribute::read(int32_t* value) {
+	int64_t m;
+	int d;
+	int err = readRaw(&m, &d);
+	if (err < 0)
+		return err;
+	while (d-- > 0)
+		m /= 10;
+	*value = int32_t(m);
+	return 0;
+}
+
+int SysfsAttribute::read(float* value) {
+	static const float scale[] = { 1.0f, 1e-1f, 1e-2f, 1e-3f, 1e-4f, 1e-5f,
+			1e-6f, 1e-7f, 1e-8f, 1e-9f };
+	int64_t m;
+	int d;
+	int err = readRaw(&m, &d);
+	if (err < 0)
+		return err;
+	*value = float(m) * scale[d];
+	return 0;
+}
+
+int SysfsAttribute::write(int64_t value) {
+	char buffer[24];
+
+	if (mHasWritten && value == mWritten)
+		return 0;
+	if (mFd < 0 && open() < 0)
+		return -EBADF;
+	int len = snprintf(buffer, sizeof(buffer), "%lld", (long long) value);
+	if (pwrite(mFd, buffer, len, 0) != len) {
+		ALOGE("write to %s failed (%s)", mPath, strerror(errno));
+		return -errno;
+	}
+	mWritten = value;
+	mHasWritten = true;
+	return 0;
+}
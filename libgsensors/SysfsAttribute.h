@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_SYSFS_ATTRIBUTE_H
+#define ANDROID_SYSFS_ATTRIBUTE_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Numeric sysfs attribute kept open between accesses. Reads go through
+ * pread() at offset 0 and are parsed in place, writes of the value the
+ * attribute already holds are skipped.
+ */
+class SysfsAttribute {
+	const char* const mPath;
+	const int mFlags;
+	int mFd;
+	int64_t mWritten;
+	bool mHasWritten;
+	bool mWarned;
+
+	int readRaw(int64_t* mantissa, int* decimals);
+
+public:
+	SysfsAttribute(const char* path, int flags);
+	~SysfsAttribute();
+
+	/*
+	 * Drivers call this on enable rather than from their constructor:
+	 * reads fail on a handle opened at boot. The attribute then stays
+	 * open, and is re-read, while the sensor is enabled.
+	 */
+	int open();
+	void close();
+	int getFd() const { return mFd; }
+	const char* getPath() const { return mPath; }
+
+	int read(int32_t* value);
+	int read(float* value);
+	/* returns 0 without touching the file if value is already set */
+	int write(int64_t value);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SYSFS_ATTRIBUTE_H
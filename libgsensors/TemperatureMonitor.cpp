@@ -23,7 +23,15 @@
 /*****************************************************************************/
 
 #define FIRST_GOOD_EVENT    5
-#define TEMP_SYSFS_PATH  "/sys/class/hwmon/hwmon0/device/temp2_input"
+#define TEMP_SYSFS_PATH  SYSFS_ROOT "/sys/class/hwmon/hwmon0/device/temp2_input"
+
+/*
+ * temp2_input counts millidegrees: report changes of half a degree, at
+ * most once a second; ro.sensors.temperature.change overrides
+ */
+#define TEMP_CHANGE_ABSOLUTE 500.0f
+#define TEMP_CHANGE_RELATIVE 0.0f
+#define TEMP_CHANGE_INTERVAL 1000000000LL
 
 /* return the current time in nanoseconds */
 extern int64_t now_ns(void);
@@ -32,10 +40,12 @@ TemperatureMonitor::TemperatureMonitor()
     : SensorBase(NULL, NULL),
       mEnabled(0),
       mHasPendingEvent(false),
-      mAlready_warned(false),
-      mLast_value(-1)
+      mFilter("ro.sensors.temperature.change", TEMP_CHANGE_ABSOLUTE,
+              TEMP_CHANGE_RELATIVE, TEMP_CHANGE_INTERVAL),
+      mTemp(TEMP_SYSFS_PATH, O_RDONLY)
 {
     delay_time = 200000000LL;
+    open_timer();
 }
 
 TemperatureMonitor::~TemperatureMonitor() {
@@ -43,6 +53,8 @@ TemperatureMonitor::~TemperatureMonitor() {
 
 int TemperatureMonitor::setDelay(int32_t handle, int64_t ns) {
     delay_time = ns;
+    if (mEnabled)
+        return set_timer(delay_time);
     return 0;
 }
 
@@ -51,20 +63,19 @@ int64_t TemperatureMonitor::getDelay() const {
 }
 
 int TemperatureMonitor::enable(int32_t handle, int en) {
-    if (en != 0)
+    if (en != 0) {
+        mTemp.open();
+        mFilter.reset();
         mEnabled = true;
-    else
+        set_timer(delay_time);
+    } else {
         mEnabled = false;
+        set_timer(0);
+        mTemp.close();
+    }
     return 0;
 }
 
-bool TemperatureMonitor::hasPendingEvents() const {
-    if(mEnabled)
-        return true;
-    else
-        return false;
-}
-
 int TemperatureMonitor::readEvents(sensors_event_t* data, int count) {
     static int log_count = 0;
     static float value = -1.0f;
@@ -75,36 +86,17 @@ int TemperatureMonitor::readEvents(sensors_event_t* data, int count) {
         return 0;
     }
 
-    /* The opening of the file handle is placed here
-     * as work around that if it is opened in the constructor
-     * read on the file handle fails.
-     */
-    data_fd = open(TEMP_SYSFS_PATH, O_RDONLY);
-    if (data_fd < 0)
+    if (mTemp.read(&value) < 0)
         return 0;
-
-    int numEventReceived = 0;
-    input_event const* event;
-    char buffer[20] = {0};
-
-    int amt = read(data_fd, buffer, sizeof(buffer));
-    close(data_fd);
-
-    if (amt <= 0 && mAlready_warned == false) {
-        ALOGE("TemperatureMonitor: read from %s failed", TEMP_SYSFS_PATH);
-        mAlready_warned = false;
-        return 0;
-    }
-    value = atof(buffer);
-    if (value == mLast_value)
+    int64_t now = now_ns();
+    if (!mFilter.update(value, now))
        return 0;
     evt.version = sizeof(sensors_event_t);
     evt.sensor = ID_T;
     evt.type = SENSOR_TYPE_TEMPERATURE;
     evt.temperature = value;
-    evt.timestamp = now_ns();
+    evt.timestamp = now;
     *data = evt;
-    mLast_value = value;
     ALOGE("TemperatureMonitor: value is %i", (int)value );
     return 1;
 }
@@ -19,6 +19,7 @@
 
 #include "sensors.h"
 #include "SensorBase.h"
+#include "ChangeFilter.h"
 
 /*****************************************************************************/
 
@@ -27,14 +28,13 @@ struct input_event;
 class TemperatureMonitor : public SensorBase {
     int mEnabled;
     bool mHasPendingEvent;
-    float mLast_value;
-    bool mAlready_warned;
+    ChangeFilter mFilter;
+    SysfsAttribute mTemp;
 
 public:
             TemperatureMonitor();
     virtual ~TemperatureMonitor();
     virtual int readEvents(sensors_event_t* data, int count);
-    virtual bool hasPendingEvents() const;
     virtual int setDelay(int32_t handle, int64_t ns);
     virtual int64_t getDelay() const;
     virtual int enable(int32_t handle, int enabled);
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "TimestampFilter.h"
+
+/*****************************************************************************/
+
+/* share of the prediction error applied to the time and to the period */
+#define PHASE_GAIN_SHIFT	4
+#define PERIOD_GAIN_SHIFT	8
+/* how far the period may drift off its nominal value, as 1/n of it */
+#define MAX_DRIFT_SHIFT		4
+
+TimestampFilter::TimestampFilter() :
+	mNominalPeriod(0) {
+	reset();
+}
+
+void TimestampFilter::setPeriod(int64_t period) {
+	if (period != mNominalPeriod) {
+		mNominalPeriod = period;
+		reset();
+	}
+}
+
+void TimestampFilter::reset() {
+	mPeriod = mNominalPeriod;
+	mLast = 0;
+	mLocked = false;
+}
+
+int64_t TimestampFilter::filter(int64_t timestamp) {
+	if (mNominalPeriod <= 0)
+		return timestamp;
+
+	const int64_t predicted = mLast + mPeriod;
+	const int64_t error = timestamp - predicted;
+	if (!mLocked || error > mPeriod / 2 || error < -mPeriod / 2) {
+		// stay ordered should the raw stamps ever go backwards
+		mLast = (mLocked && timestamp <= mLast) ? mLast + 1 : timestamp;
+		mPeriod = mNominalPeriod;
+		mLocked = true;
+		return mLast;
+	}
+
+	// never later than the interrupt that reported the sample; the raw
+	// stamp is over half a period past the previous one, so this stays
+	// monotonic
+	const int64_t filtered = predicted + (error >> PHASE_GAIN_SHIFT);
+	mLast = filtered < timestamp ? filtered : timestamp;
+	mPeriod += error >> PERIOD_GAIN_SHIFT;
+	const int64_t drift = mNominalPeriod >> MAX_DRIFT_SHIFT;
+	if (mPeriod > mNominalPeriod + drift)
+		mPeriod = mNominalPeriod + drift;
+	else if (mPeriod < mNominalPeriod - drift)
+		mPeriod = mNominalPeriod - drift;
+
+	return mLast;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ANDROID_TIMESTAMP_FILTER_H
+#define ANDROID_TIMESTAMP_FILTER_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/*****************************************************************************/
+
+/*
+ * Rebuilds evenly spaced sample times from the jittery interrupt stamps
+ * of a sensor running at a known output data rate. The period is tracked
+ * to follow the drift of the sensor oscillator; a stamp far off the
+ * prediction (a gap, a rate change) restarts the filter from it. A
+ * sample time is never later than its raw stamp.
+ */
+class TimestampFilter {
+	int64_t mNominalPeriod;
+	int64_t mPeriod;
+	int64_t mLast;
+	bool mLocked;
+
+public:
+	TimestampFilter();
+
+	/* period the sensor runs at, 0 when unknown; restarts if it changed */
+	void setPeriod(int64_t period);
+	void reset();
+	int64_t filter(int64_t timestamp);
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_TIMESTAMP_FILTER_H
@@ -0,0 +1,464 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replay benchmark of the sensors HAL on a Linux host.
+ *
+ *   sensors_bench [-m driver|hal] [-f capture] [-n samples] [-r hz] [-s]
+ *
+ * The accelerometer stream is either a capture of struct input_event
+ * records (as produced by cat /dev/input/eventN) or a synthetic sine at
+ * -r Hz. In driver mode it is written through a blocking pipe straight
+ * into Accelerometer::readEvents(), called only when SensorThread would
+ * call it, so that a driver reading with nothing to read hangs the run
+ * until DRIVER_TIMEOUT_S aborts it; in hal mode a uinput device named
+ * "gsensor" is created and the whole module is driven through poll().
+ * -s also enables the sysfs sensors, which read from the scratch tree
+ * under SYSFS_ROOT. Reports events/s, CPU time per event and, in hal
+ * mode, the p50/p99 latency from the evdev timestamp to poll() return
+ * and how many of the replayed samples did not come out of the HAL.
+ *
+ * Outside an AOSP tree, bench/Makefile builds it against the stand-in
+ * headers under bench/stubs.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "sensors.h"
+#include "Accelerometer.h"
+
+/*****************************************************************************/
+
+extern struct sensors_module_t HAL_MODULE_INFO_SYM;
+
+/* the files the drivers read, relative to SYSFS_ROOT or DATA_ROOT */
+static const struct {
+	const char* root;
+	const char* path;
+	const char* value;
+} sSysfsTree[] = {
+	{ SYSFS_ROOT, "/sys/bus/iio/devices/device0/lux", "120\n" },
+	{ SYSFS_ROOT, "/sys/bus/iio/devices/device0/proxim_ir", "100\n" },
+	{ SYSFS_ROOT, "/sys/class/hwmon/hwmon0/device/temp2_input", "35000\n" },
+	{ SYSFS_ROOT, "/sys/devices/platform/s3c2440-i2c.0/i2c-0/0-0018/delay",
+			"40\n" },
+	{ DATA_ROOT, "/data/system/gsensor_calibration",
+			"1 0 0\n0 1 0\n0 0 1\n0 0 0\n" },
+};
+
+/* how long udev gets to create the /dev/input node of the uinput device */
+#define NODE_TIMEOUT_MS		5000
+
+/* how long the last replayed samples get to make it through the HAL */
+#define DRAIN_MS			500
+
+/* how long driver mode may take over one chunk before it is a hang */
+#define DRIVER_TIMEOUT_S	10
+
+static std::vector<input_event> sStream;
+static int sRate = 200;
+static sensors_poll_device_1_t* sDevice;
+
+static int64_t clockNs(clockid_t clock) {
+	struct timespec t;
+	clock_gettime(clock, &t);
+	return int64_t(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
+static int64_t cpuNs() {
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000LL
+			+ (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000LL;
+}
+
+static int makeTree() {
+	for (size_t i = 0; i < ARRAY_SIZE(sSysfsTree); i++) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s%s", sSysfsTree[i].root,
+				sSysfsTree[i].path);
+		for (char* p = path + 1; *p; p++) {
+			if (*p == '/') {
+				*p = '\0';
+				mkdir(path, 0755);
+				*p = '/';
+			}
+		}
+		FILE* f = fopen(path, "w");
+		if (!f) {
+			fprintf(stderr, "can't create %s (%s)\n", path, strerror(errno));
+			return -1;
+		}
+		fputs(sSysfsTree[i].value, f);
+		fclose(f);
+	}
+	return 0;
+}
+
+static void pushEvent(int64_t t, int type, int code, int value) {
+	input_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.time.tv_sec = t / 1000000000LL;
+	ev.time.tv_usec = (t % 1000000000LL) / 1000;
+	ev.type = type;
+	ev.code = code;
+	ev.value = value;
+	sStream.push_back(ev);
+}
+
+static int loadStream(const char* capture, int samples) {
+	if (capture) {
+		FILE* f = fopen(capture, "rb");
+		if (!f) {
+			fprintf(stderr, "can't open %s (%s)\n", capture, strerror(errno));
+			return -1;
+		}
+		input_event ev;
+		while (fread(&ev, sizeof(ev), 1, f) == 1) {
+			if (ev.type == EV_ABS || ev.type == EV_SYN)
+				sStream.push_back(ev);
+		}
+		fclose(f);
+		return 0;
+	}
+
+	// values change every sample, the input core drops repeated ones
+	const int hz = sRate > 0 ? sRate : 200;
+	for (int i = 0; i < samples; i++) {
+		int64_t t = int64_t(i) * 1000000000LL / hz;
+		double phase = 2 * M_PI * i / 50.0;
+		pushEvent(t, EV_ABS, ABS_X, int(200 * sin(phase)) + (i & 1));
+		pushEvent(t, EV_ABS, ABS_Y, int(200 * cos(phase)) + (i & 1));
+		pushEvent(t, EV_ABS, ABS_Z, 819 + (i & 1));
+		pushEvent(t, EV_SYN, SYN_REPORT, 0);
+	}
+	return 0;
+}
+
+static size_t countSamples() {
+	size_t n = 0;
+	for (size_t i = 0; i < sStream.size(); i++) {
+		if (sStream[i].type == EV_SYN)
+			n++;
+	}
+	return n;
+}
+
+static void report(const char* mode, size_t events, int64_t wall, int64_t cpu,
+		std::vector<int64_t>& latencies) {
+	printf("%s: %zu events in %.3f s\n", mode, events, wall / 1e9);
+	if (!events)
+		return;
+	printf("  throughput   %10.0f events/s\n", events * 1e9 / wall);
+	printf("  cpu          %10.0f ns/event\n", double(cpu) / events);
+	if (latencies.empty())
+		return;
+	std::sort(latencies.begin(), latencies.end());
+	printf("  latency p50  %10.0f us\n", latencies[latencies.size() / 2] / 1e3);
+	printf("  latency p99  %10.0f us\n",
+			latencies[latencies.size() * 99 / 100] / 1e3);
+}
+
+/*****************************************************************************/
+
+/* gives the benchmark the fd the driver reads from */
+class BenchAccelerometer : public Accelerometer {
+public:
+	void attach(int fd) {
+		data_fd = fd;
+	}
+};
+
+static int runDriver() {
+	int fds[2];
+	if (pipe(fds) < 0) {
+		perror("pipe");
+		return 1;
+	}
+
+	BenchAccelerometer accel;
+	accel.attach(fds[0]);
+	accel.enable(ID_A, 1);
+	// keep every sample, decimation is not what is measured here
+	accel.setDelay(ID_A, 0);
+
+	// chunks stay below PIPE_BUF so that writes never split an event
+	const size_t chunk = 4096 / sizeof(input_event);
+	sensors_event_t buffer[32];
+	size_t events = 0;
+	size_t reads = 0;
+	int64_t wall = clockNs(CLOCK_MONOTONIC);
+	int64_t cpu = cpuNs();
+	for (size_t i = 0; i < sStream.size(); i += chunk) {
+		size_t n = std::min(chunk, sStream.size() - i);
+		write(fds[1], &sStream[i], n * sizeof(input_event));
+		// as SensorThread: read on samples left over or a readable fd
+		struct pollfd pfd = { fds[0], POLLIN, 0 };
+		alarm(DRIVER_TIMEOUT_S);
+		while (accel.hasPendingEvents() || poll(&pfd, 1, 0) > 0) {
+			// varying room, so that samples are left over in the ring
+			int nb = accel.readEvents(buffer,
+					1 + reads++ % ARRAY_SIZE(buffer));
+			if (nb > 0)
+				events += nb;
+		}
+	}
+	alarm(0);
+	wall = clockNs(CLOCK_MONOTONIC) - wall;
+	cpu = cpuNs() - cpu;
+
+	std::vector<int64_t> none;
+	report("driver", events, wall, cpu, none);
+	close(fds[1]);
+	return 0;
+}
+
+/*****************************************************************************/
+
+static int createUinput() {
+	int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+	if (fd < 0) {
+		fprintf(stderr, "can't open /dev/uinput (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	struct uinput_user_dev dev;
+	memset(&dev, 0, sizeof(dev));
+	strncpy(dev.name, "gsensor", UINPUT_MAX_NAME_SIZE);
+	dev.id.bustype = BUS_VIRTUAL;
+	for (int axis = ABS_X; axis <= ABS_Z; axis++) {
+		ioctl(fd, UI_SET_ABSBIT, axis);
+		dev.absmin[axis] = -2048;
+		dev.absmax[axis] = 2047;
+	}
+	ioctl(fd, UI_SET_EVBIT, EV_ABS);
+	ioctl(fd, UI_SET_EVBIT, EV_SYN);
+	if (write(fd, &dev, sizeof(dev)) != sizeof(dev)
+			|| ioctl(fd, UI_DEV_CREATE) < 0) {
+		fprintf(stderr, "can't create uinput device (%s)\n", strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* true once an event node with the given name can be opened */
+static bool findNode(const char* name) {
+	DIR* dir = opendir("/dev/input");
+	if (!dir)
+		return false;
+	bool found = false;
+	struct dirent* de;
+	while (!found && (de = readdir(dir))) {
+		if (strncmp(de->d_name, "event", 5))
+			continue;
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "/dev/input/%s", de->d_name);
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			continue;
+		char devname[80];
+		if (ioctl(fd, EVIOCGNAME(sizeof(devname) - 1), devname) >= 0) {
+			devname[sizeof(devname) - 1] = '\0';
+			found = !strcmp(devname, name);
+		}
+		close(fd);
+	}
+	closedir(dir);
+	return found;
+}
+
+/* udev creates the node asynchronously, wait until the HAL can open it */
+static int waitForNode(const char* name) {
+	int64_t deadline = clockNs(CLOCK_MONOTONIC) + NODE_TIMEOUT_MS * 1000000LL;
+	while (!findNode(name)) {
+		if (clockNs(CLOCK_MONOTONIC) > deadline) {
+			fprintf(stderr, "no /dev/input node for %s\n", name);
+			return -1;
+		}
+		usleep(10000);
+	}
+	return 0;
+}
+
+static void* replayThread(void* arg) {
+	int fd = *static_cast<int*> (arg);
+	int64_t start = clockNs(CLOCK_MONOTONIC);
+	int64_t first = -1;
+	size_t begin = 0;
+
+	for (size_t i = 0; i < sStream.size(); i++) {
+		if (sStream[i].type != EV_SYN)
+			continue;
+		int64_t t = sStream[i].time.tv_sec * 1000000000LL
+				+ sStream[i].time.tv_usec * 1000LL;
+		if (first < 0)
+			first = t;
+		if (sRate > 0) {
+			int64_t wait = start + (t - first) - clockNs(CLOCK_MONOTONIC);
+			if (wait > 0) {
+				struct timespec ts = { time_t(wait / 1000000000LL),
+						long(wait % 1000000000LL) };
+				nanosleep(&ts, NULL);
+			}
+		}
+		// the kernel stamps the events itself when they are injected
+		write(fd, &sStream[begin], (i + 1 - begin) * sizeof(input_event));
+		begin = i + 1;
+	}
+
+	// the flush completion tells the poll loop the replay is over
+	usleep(DRAIN_MS * 1000);
+	sDevice->flush(sDevice, ID_A);
+	return NULL;
+}
+
+/* the HAL stamps every event with CLOCK_MONOTONIC */
+static int64_t latencyOf(int64_t timestamp) {
+	return clockNs(CLOCK_MONOTONIC) - timestamp;
+}
+
+static int runHal(bool sysfs) {
+	int uinput = createUinput();
+	if (uinput < 0)
+		return 1;
+	if (waitForNode("gsensor") < 0) {
+		ioctl(uinput, UI_DEV_DESTROY);
+		close(uinput);
+		return 1;
+	}
+
+	hw_module_t* module = &HAL_MODULE_INFO_SYM.common;
+	hw_device_t* device;
+	if (module->methods->open(module, SENSORS_HARDWARE_POLL, &device)) {
+		fprintf(stderr, "can't open the sensors HAL\n");
+		return 1;
+	}
+	sensors_poll_device_1_t* dev = (sensors_poll_device_1_t*) device;
+	sDevice = dev;
+	int64_t period = sRate > 0 ? 1000000000LL / sRate : 0;
+	dev->batch(dev, ID_A, 0, period, 0);
+	dev->activate(&dev->v0, ID_A, 1);
+	if (sysfs) {
+		dev->activate(&dev->v0, ID_L, 1);
+		dev->activate(&dev->v0, ID_T, 1);
+	}
+
+	pthread_t replay;
+	size_t expected = countSamples();
+	pthread_create(&replay, NULL, replayThread, &uinput);
+
+	std::vector<int64_t> latencies;
+	latencies.reserve(expected);
+	sensors_event_t buffer[16];
+	size_t events = 0;
+	int64_t start = clockNs(CLOCK_MONOTONIC);
+	int64_t last = start;
+	int64_t cpu = cpuNs();
+	bool done = false;
+	while (!done) {
+		int nb = dev->poll(&dev->v0, buffer, ARRAY_SIZE(buffer));
+		if (nb < 0)
+			break;
+		for (int i = 0; i < nb; i++) {
+			if (buffer[i].type == SENSOR_TYPE_META_DATA) {
+				done |= buffer[i].meta_data.what == META_DATA_FLUSH_COMPLETE
+						&& buffer[i].meta_data.sensor == ID_A;
+				continue;
+			}
+			if (buffer[i].sensor != ID_A)
+				continue;
+			latencies.push_back(latencyOf(buffer[i].timestamp));
+			last = clockNs(CLOCK_MONOTONIC);
+			events++;
+		}
+	}
+	// the drain time after the replay is not part of the run
+	int64_t wall = last - start;
+	cpu = cpuNs() - cpu;
+
+	pthread_join(replay, NULL);
+	report("hal", events, wall, cpu, latencies);
+	// dropped, decimated or merged samples; the first sample read on
+	// activate can make up for one of them
+	if (events != expected)
+		printf("  shortfall    %10ld of %zu samples\n",
+				long(expected) - long(events), expected);
+
+	dev->activate(&dev->v0, ID_A, 0);
+	device->close(device);
+	ioctl(uinput, UI_DEV_DESTROY);
+	close(uinput);
+	return 0;
+}
+
+/*****************************************************************************/
+
+int main(int argc, char** argv) {
+	const char* mode = "driver";
+	const char* capture = NULL;
+	int samples = 20000;
+	bool sysfs = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "m:f:n:r:s")) != -1) {
+		switch (c) {
+		case 'm':
+			mode = optarg;
+			break;
+		case 'f':
+			capture = optarg;
+			break;
+		case 'n':
+			samples = atoi(optarg);
+			break;
+		case 'r':
+			sRate = atoi(optarg);
+			break;
+		case 's':
+			sysfs = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-m driver|hal] [-f capture] "
+					"[-n samples] [-r hz] [-s]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (makeTree() < 0 || loadStream(capture, samples) < 0)
+		return 1;
+	if (!strcmp(mode, "hal"))
+		return runHal(sysfs);
+	return runDriver();
+}
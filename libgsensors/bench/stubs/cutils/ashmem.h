@@ -0,0 +1,30 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+#ifndef GSENSORS_STUB_CUTILS_ASHMEM_H
+#define GSENSORS_STUB_CUTILS_ASHMEM_H
+
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* a memfd behaves like an ashmem region as far as the HAL is concerned */
+static inline int ashmem_create_region(const char* name, size_t size) {
+	int fd = syscall(SYS_memfd_create, name, 0);
+	if (fd >= 0 && ftruncate(fd, size) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static inline int ashmem_set_prot_region(int fd, int prot) {
+	(void)fd;
+	(void)prot;
+	return 0;
+}
+
+#endif // GSENSORS_STUB_CUTILS_ASHMEM_H
@@ -0,0 +1,67 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+#ifndef GSENSORS_STUB_CUTILS_ATOMIC_H
+#define GSENSORS_STUB_CUTILS_ATOMIC_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+static inline int32_t android_atomic_inc(volatile int32_t* addr) {
+	return __atomic_fetch_add(addr, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t android_atomic_dec(volatile int32_t* addr) {
+	return __atomic_fetch_sub(addr, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t android_atomic_add(int32_t value, volatile int32_t* addr) {
+	return __atomic_fetch_add(addr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t android_atomic_and(int32_t value, volatile int32_t* addr) {
+	return __atomic_fetch_and(addr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t android_atomic_or(int32_t value, volatile int32_t* addr) {
+	return __atomic_fetch_or(addr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t android_atomic_acquire_load(volatile const int32_t* addr) {
+	return __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+}
+
+static inline int32_t android_atomic_release_load(volatile const int32_t* addr) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return __atomic_load_n(addr, __ATOMIC_RELAXED);
+}
+
+static inline void android_atomic_acquire_store(int32_t value, volatile int32_t* addr) {
+	__atomic_store_n(addr, value, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void android_atomic_release_store(int32_t value, volatile int32_t* addr) {
+	__atomic_store_n(addr, value, __ATOMIC_RELEASE);
+}
+
+/* the cas variants return 0 when the swap happened, like bionic's */
+static inline int android_atomic_acquire_cas(int32_t oldvalue, int32_t newvalue,
+		volatile int32_t* addr) {
+	return !__atomic_compare_exchange_n(addr, &oldvalue, newvalue, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE);
+}
+
+static inline int android_atomic_release_cas(int32_t oldvalue, int32_t newvalue,
+		volatile int32_t* addr) {
+	return !__atomic_compare_exchange_n(addr, &oldvalue, newvalue, false,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+#define android_atomic_write	android_atomic_release_store
+#define android_atomic_cmpxchg	android_atomic_release_cas
+
+#endif // GSENSORS_STUB_CUTILS_ATOMIC_H
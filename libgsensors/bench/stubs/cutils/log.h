@@ -0,0 +1,37 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+#ifndef GSENSORS_STUB_CUTILS_LOG_H
+#define GSENSORS_STUB_CUTILS_LOG_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef LOG_TAG
+#define LOG_TAG NULL
+#endif
+
+#define __gsensors_log(level, ...) \
+	((void)fprintf(stderr, level "/%s: ", LOG_TAG ? LOG_TAG : ""), \
+	 (void)fprintf(stderr, __VA_ARGS__), (void)fputc('\n', stderr))
+
+/* compiled out as with LOG_NDEBUG, but still type-checked */
+#define ALOGV(...)	do { if (0) __gsensors_log("V", __VA_ARGS__); } while (0)
+#define ALOGD(...)	__gsensors_log("D", __VA_ARGS__)
+#define ALOGI(...)	__gsensors_log("I", __VA_ARGS__)
+#define ALOGW(...)	__gsensors_log("W", __VA_ARGS__)
+#define ALOGE(...)	__gsensors_log("E", __VA_ARGS__)
+
+#define ALOGV_IF(cond, ...)	do { if (0 && (cond)) __gsensors_log("V", __VA_ARGS__); } while (0)
+#define ALOGD_IF(cond, ...)	((cond) ? ALOGD(__VA_ARGS__) : (void)0)
+#define ALOGI_IF(cond, ...)	((cond) ? ALOGI(__VA_ARGS__) : (void)0)
+#define ALOGW_IF(cond, ...)	((cond) ? ALOGW(__VA_ARGS__) : (void)0)
+#define ALOGE_IF(cond, ...)	((cond) ? ALOGE(__VA_ARGS__) : (void)0)
+
+#endif // GSENSORS_STUB_CUTILS_LOG_H
@@ -0,0 +1,37 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+#ifndef GSENSORS_STUB_CUTILS_PROPERTIES_H
+#define GSENSORS_STUB_CUTILS_PROPERTIES_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PROPERTY_KEY_MAX	32
+#define PROPERTY_VALUE_MAX	92
+
+/*
+ * No property service on the host: a property is read from the
+ * environment, with the dots of its key turned into underscores
+ * (ro.sensors.light.buffered is ro_sensors_light_buffered).
+ */
+static inline int property_get(const char* key, char* value,
+		const char* default_value) {
+	char name[PROPERTY_KEY_MAX];
+	size_t i;
+	for (i = 0; key[i] && i < sizeof(name) - 1; i++)
+		name[i] = key[i] == '.' ? '_' : key[i];
+	name[i] = '\0';
+
+	const char* found = getenv(name);
+	if (!found)
+		found = default_value ? default_value : "";
+	strncpy(value, found, PROPERTY_VALUE_MAX - 1);
+	value[PROPERTY_VALUE_MAX - 1] = '\0';
+	return strlen(value);
+}
+
+#endif // GSENSORS_STUB_CUTILS_PROPERTIES_H
@@ -0,0 +1,173 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+#ifndef GSENSORS_STUB_HARDWARE_SENSORS_H
+#define GSENSORS_STUB_HARDWARE_SENSORS_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include <hardware/hardware.h>
+
+__BEGIN_DECLS
+
+#define SENSORS_HEADER_VERSION			1
+#define SENSORS_MODULE_API_VERSION_0_1	HARDWARE_MODULE_API_VERSION(0, 1)
+#define SENSORS_DEVICE_API_VERSION_0_1	\
+	HARDWARE_DEVICE_API_VERSION_2(0, 1, SENSORS_HEADER_VERSION)
+#define SENSORS_DEVICE_API_VERSION_1_0	\
+	HARDWARE_DEVICE_API_VERSION_2(1, 0, SENSORS_HEADER_VERSION)
+#define SENSORS_DEVICE_API_VERSION_1_1	\
+	HARDWARE_DEVICE_API_VERSION_2(1, 1, SENSORS_HEADER_VERSION)
+
+#define SENSORS_HARDWARE_MODULE_ID "sensors"
+#define SENSORS_HARDWARE_POLL "poll"
+
+#define SENSOR_HANDLE_BASE 0
+
+#define SENSORS_BATCH_DRY_RUN				0x00000001
+#define SENSORS_BATCH_WAKE_UPON_FIFO_FULL	0x00000002
+
+enum {
+	META_DATA_FLUSH_COMPLETE = 1,
+	META_DATA_VERSION
+};
+
+#define SENSOR_TYPE_META_DATA				(0)
+#define SENSOR_TYPE_ACCELEROMETER			(1)
+#define SENSOR_TYPE_GEOMAGNETIC_FIELD		(2)
+#define SENSOR_TYPE_MAGNETIC_FIELD			SENSOR_TYPE_GEOMAGNETIC_FIELD
+#define SENSOR_TYPE_ORIENTATION				(3)
+#define SENSOR_TYPE_GYROSCOPE				(4)
+#define SENSOR_TYPE_LIGHT					(5)
+#define SENSOR_TYPE_PRESSURE				(6)
+#define SENSOR_TYPE_TEMPERATURE				(7)
+#define SENSOR_TYPE_PROXIMITY				(8)
+#define SENSOR_TYPE_GRAVITY					(9)
+#define SENSOR_TYPE_LINEAR_ACCELERATION		(10)
+#define SENSOR_TYPE_ROTATION_VECTOR			(11)
+#define SENSOR_TYPE_RELATIVE_HUMIDITY		(12)
+#define SENSOR_TYPE_AMBIENT_TEMPERATURE		(13)
+#define SENSOR_TYPE_SIGNIFICANT_MOTION		(17)
+#define SENSOR_TYPE_STEP_DETECTOR			(18)
+#define SENSOR_TYPE_STEP_COUNTER			(19)
+
+#define SENSOR_STATUS_UNRELIABLE		0
+#define SENSOR_STATUS_ACCURACY_LOW		1
+#define SENSOR_STATUS_ACCURACY_MEDIUM	2
+#define SENSOR_STATUS_ACCURACY_HIGH		3
+
+#define GRAVITY_SUN		(275.0f)
+#define GRAVITY_EARTH	(9.80665f)
+
+typedef struct {
+	union {
+		float v[3];
+		struct {
+			float x;
+			float y;
+			float z;
+		};
+		struct {
+			float azimuth;
+			float pitch;
+			float roll;
+		};
+	};
+	int8_t status;
+	uint8_t reserved[3];
+} sensors_vec_t;
+
+typedef struct meta_data_event {
+	int32_t what;
+	int32_t sensor;
+} meta_data_event_t;
+
+typedef struct sensors_event_t {
+	int32_t version;
+	int32_t sensor;
+	int32_t type;
+	int32_t reserved0;
+	int64_t timestamp;
+	union {
+		union {
+			float data[16];
+			sensors_vec_t acceleration;
+			sensors_vec_t magnetic;
+			sensors_vec_t orientation;
+			sensors_vec_t gyro;
+			float temperature;
+			float distance;
+			float light;
+			float pressure;
+			float relative_humidity;
+			meta_data_event_t meta_data;
+		};
+		union {
+			uint64_t data[8];
+			uint64_t step_counter;
+		} u64;
+	};
+	uint32_t flags;
+	uint32_t reserved1[3];
+} sensors_event_t;
+
+struct sensor_t;
+
+struct sensors_module_t {
+	struct hw_module_t common;
+	int (*get_sensors_list)(struct sensors_module_t* module,
+			struct sensor_t const** list);
+};
+
+struct sensor_t {
+	const char* name;
+	const char* vendor;
+	int version;
+	int handle;
+	int type;
+	float maxRange;
+	float resolution;
+	float power;
+	int32_t minDelay;
+	uint32_t fifoReservedEventCount;
+	uint32_t fifoMaxEventCount;
+	void* reserved[6];
+};
+
+struct sensors_poll_device_t {
+	struct hw_device_t common;
+	int (*activate)(struct sensors_poll_device_t* dev, int handle,
+			int enabled);
+	int (*setDelay)(struct sensors_poll_device_t* dev, int handle,
+			int64_t period_ns);
+	int (*poll)(struct sensors_poll_device_t* dev, sensors_event_t* data,
+			int count);
+};
+
+typedef struct sensors_poll_device_1 {
+	union {
+		struct sensors_poll_device_t v0;
+		struct {
+			struct hw_device_t common;
+			int (*activate)(struct sensors_poll_device_t* dev, int handle,
+					int enabled);
+			int (*setDelay)(struct sensors_poll_device_t* dev, int handle,
+					int64_t period_ns);
+			int (*poll)(struct sensors_poll_device_t* dev,
+					sensors_event_t* data, int count);
+		};
+	};
+	int (*batch)(struct sensors_poll_device_1* dev, int handle, int flags,
+			int64_t period_ns, int64_t timeout);
+	int (*flush)(struct sensors_poll_device_1* dev, int handle);
+	void (*reserved_procs[8])(void);
+} sensors_poll_device_1_t;
+
+__END_DECLS
+
+#endif // GSENSORS_STUB_HARDWARE_SENSORS_H
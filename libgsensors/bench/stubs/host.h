@@ -0,0 +1,12 @@
+/*
+ * Minimal stand-ins for the AOSP headers the HAL includes, only enough of
+ * them to build sensors_bench on a plain Linux host outside the AOSP tree
+ * (see bench/Makefile). The AOSP host build uses the real ones.
+ */
+
+/*
+ * Forced into every translation unit by bench/Makefile: bionic and the
+ * AOSP headers pull these in transitively, glibc does not.
+ */
+#include <limits.h>
+#include <string.h>
@@ -21,10 +21,15 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <dirent.h>
+#include <limits.h>
 #include <math.h>
 #include <poll.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include <linux/input.h>
 #include <utils/Atomic.h>
 #include <utils/Log.h>
@@ -34,46 +39,84 @@
 #include "ProximitySensor.h"
 #include "Accelerometer.h"
 #include "TemperatureMonitor.h"
+#include "SensorFifo.h"
+#include "PackedSensorFifo.h"
+#include "SensorEventQueue.h"
+#include "SensorThread.h"
+#include "SensorReactor.h"
+#include "SensorStats.h"
+#include "InputDeviceIndex.h"
+#include "DirectChannel.h"
 
 /*****************************************************************************/
 
 #define DELAY_OUT_TIME 0x7FFFFFFF
 
-#define SENSORS_ACCELERATION     (1<<ID_A)
-#define SENSORS_LIGHT            (1<<ID_L)
-#define SENSORS_PROXIMITY        (1<<ID_P)
-#define SENSORS_TEMPERATURE      (1<<ID_T)
+/* events in flight between the reader threads and the poll thread */
+#define EVENT_QUEUE_SIZE 512
 
-#define SENSORS_ACCELERATION_HANDLE     0
-#define SENSORS_LIGHT_HANDLE            1
-#define SENSORS_PROXIMITY_HANDLE        2
-#define SENSORS_TEMPERATURE_HANDLE      3
+/*
+ * abstract unix socket serving the delivery statistics, e.g.
+ *   adb forward tcp:5039 localabstract:gsensors_stats && nc localhost 5039
+ */
+#define STATS_SOCKET_NAME "gsensors_stats"
+
+/*
+ * direct consumers connect to the abstract socket DIRECT_SOCKET_NAME,
+ * send a direct_channel_request_t and get back a status and the fd of
+ * the ring, which the sensor keeps being written to until they hang up;
+ * only root and the uid the HAL runs as may connect, and a client whose
+ * request is not in after DIRECT_REQUEST_TIMEOUT_NS gives its slot up
+ */
+#define MAX_DIRECT_CLIENTS 8
+#define DIRECT_CHANNEL_EVENTS 1024
+#define DIRECT_REQUEST_TIMEOUT_NS 100000000LL
 
 /*****************************************************************************/
 
+/*
+ * The registry of sensors.h: drivers are only created once one of their
+ * sensors is activated, the sensor list comes from it alone.
+ */
+template<class T>
+static SensorBase* createDriver() {
+	return new T();
+}
+
+static const struct driver_t {
+	SensorBase* (*create)();
+} sDrivers[numSensorDrivers] = {
+#define SENSOR_DRIVER_ENTRY(id, driverClass)	{ createDriver<driverClass> },
+	SENSOR_DRIVER_LIST(SENSOR_DRIVER_ENTRY)
+#undef SENSOR_DRIVER_ENTRY
+};
+
 /* The SENSORS Module */
-static const struct sensor_t sSensorList[] = {
-	{
-		"3-axis Accelerometer", "Analog Devices", 1,
-		SENSORS_ACCELERATION_HANDLE, SENSOR_TYPE_ACCELEROMETER, RANGE_A,
-		RESOLUTION_A, 0.23f, 20000, 0, 0, { }
-	},
-	{
-		"Intersil isl29018 Ambient Light Sensor", "Intersil", 1,
-		SENSORS_LIGHT_HANDLE, SENSOR_TYPE_LIGHT, 1000.0f, 1.0f, 1.0f, 0, 0, 0, { }
-	},
-	{
-		"Intersil isl29018 Proximity sensor", "Intersil", 1,
-		SENSORS_PROXIMITY_HANDLE, SENSOR_TYPE_PROXIMITY, 1.0f, 1.0f,
-		1.0f, 0, 0, 0, { }
-	},
-	{
-		"ADT7461 Temperature Monitor",
-		"Analog Devices", 1, SENSORS_TEMPERATURE_HANDLE,
-		SENSOR_TYPE_TEMPERATURE, 150.0f, 1.0f, 1.0f, 0, 0, 0, { }
-	},
+static const struct sensor_t sSensorList[numSensors] = {
+#define SENSOR_ENTRY(id, driver, output, name, vendor, type, maxRange, \
+		resolution, power, minDelay, fifoReserved, fifoMax) \
+	{ name, vendor, 1, ID_##id, type, maxRange, resolution, power, minDelay, \
+		fifoReserved, fifoMax, { } },
+	SENSOR_LIST(SENSOR_ENTRY)
+#undef SENSOR_ENTRY
+};
+
+/* the driver that serves each sensor, by handle */
+static const int sSensorDrivers[numSensors] = {
+#define SENSOR_DRIVER_OF(id, driver, output, name, vendor, type, maxRange, \
+		resolution, power, minDelay, fifoReserved, fifoMax)	DRIVER_##driver,
+	SENSOR_LIST(SENSOR_DRIVER_OF)
+#undef SENSOR_DRIVER_OF
 };
 
+/* the accelerometer batches far more samples packed than as whole events */
+static SensorFifo* createFifo(struct sensor_t const& sensor) {
+	if (sensor.type == SENSOR_TYPE_ACCELEROMETER)
+		return new PackedSensorFifo(sensor.handle, sensor.fifoMaxEventCount,
+				FIFO_BYTES_A);
+	return new SensorFifo(sensor.handle, sensor.fifoMaxEventCount);
+}
+
 static int open_sensors(const struct hw_module_t* module, const char* id,
 		struct hw_device_t** device);
 
@@ -100,90 +143,431 @@ struct sensors_module_t HAL_MODULE_INFO_SYM = {
 	get_sensors_list: sensors__get_sensors_list,
 };
 
+/* return the current time in nanoseconds */
+extern int64_t now_ns(void);
+
 struct sensors_poll_context_t {
-	struct sensors_poll_device_t device; // must be first
+	struct sensors_poll_device_1 device; // must be first
 
 	sensors_poll_context_t();
 	~sensors_poll_context_t();
 	int activate(int handle, int enabled);
-	void update_delay();
 	int setDelay(int handle, int64_t ns);
+	int batch(int handle, int flags, int64_t period_ns, int64_t timeout);
+	int flush(int handle);
 	int pollEvents(sensors_event_t* data, int count);
 
 private:
 	enum {
-		accelerometer = 0,
-		light = 1,
-		proximity = 2,
-		temperature = 3,
-		numSensorDrivers,
-		numFds,
+		// reactor tags of the statistics socket and /dev/input watch,
+		// of the direct channel socket and of its clients
+		statsTag = 0,
+		inputTag = 1,
+		directTag = 2,
+		directClientTag = 3,
 	};
 
-	static const size_t wake = numFds - 1;
-	static const char WAKE_MESSAGE = 'W';
-	struct pollfd mPollFds[numFds];
-	int mWritePipeFd;
-	uint32_t mEnabled;
-	uint64_t mTimeout;
+	struct direct_client_t {
+		int fd;
+		// -1 until its request is in, before deadline
+		int handle;
+		int64_t period;
+		int64_t deadline;
+	};
+
+	SensorReactor mReactor;
+	SensorStats mStats;
+	int mStatsFd;
+	SensorEventQueue mQueue;
+
+	// drivers in use and their reader threads, guarded by mDriverLock
+	pthread_mutex_t mDriverLock;
 	SensorBase* mSensors[numSensorDrivers];
+	SensorThread* mThreads[numSensorDrivers];
+	// requested by handle, replayed on a driver when it is created
+	int64_t mDelays[numSensors];
+	// shared memory rings by handle and handles which have one
+	DirectChannel* mChannels[numSensors];
+	uint32_t mDirect;
+
+	// direct channel socket and clients, only used on the poll thread
+	// but for applyDelay(): clients change under mDriverLock
+	int mDirectFd;
+	direct_client_t mDirectClients[MAX_DIRECT_CLIENTS];
+
+	// batch FIFOs by handle, guarded by mLock
+	pthread_mutex_t mLock;
+	uint32_t mEnabled;
+	SensorFifo* mFifos[numSensors];
+
+	// microseconds the events of each driver last waited in mQueue to be
+	// handed out, -1 if one of its sensors batches or has a direct
+	// channel; written by the poll thread, read by the reader threads
+	volatile int32_t mConsumerLag[numSensorDrivers];
+	// when each event mQueue.read() returned was queued, poll thread only
+	int64_t mQueued[EVENT_QUEUE_SIZE];
+
+	void wakeUp();
+	int openSocket(const char* name, uint32_t tag);
+	void dumpStats();
+	void acceptDirectClient();
+	void readDirectClient(int index);
+	void closeDirectClient(int index);
+	int openDirect(int handle);
+	void closeDirect(int handle);
+	int applyDelay(int handle);
+	void handleHotplug();
+	SensorBase* acquireDriver(int index);
+	void releaseDriver(int index);
+	int setDriverDelay(int handle, int64_t ns);
+	int batchEvents(sensors_event_t* data, int64_t const* queued, int count);
+	int drainFifos(sensors_event_t* data, int count);
+	int pollTimeout();
 
 	int handleToDriver(int handle) const {
-		switch (handle) {
-		case ID_A:
-			return accelerometer;
-		case ID_L:
-			return light;
-		case ID_P:
-			return proximity;
-		case ID_T:
-			return temperature;
-		}
-		return -EINVAL;
+		if (handle < 0 || handle >= numSensors)
+			return -EINVAL;
+		return sSensorDrivers[handle];
 	}
 };
 
 /*****************************************************************************/
 
-sensors_poll_context_t::sensors_poll_context_t() {
+sensors_poll_context_t::sensors_poll_context_t() :
+	mQueue(EVENT_QUEUE_SIZE) {
 	FUNC_LOG;
 
+	pthread_mutex_init(&mDriverLock, NULL);
+	for (int i = 0; i < numSensorDrivers; i++) {
+		mSensors[i] = NULL;
+		mThreads[i] = NULL;
+	}
+
+	pthread_mutex_init(&mLock, NULL);
 	mEnabled = 0;
-	mTimeout = -1LLU;
+	for (int i = 0; i < numSensors; i++) {
+		mFifos[i] = createFifo(sSensorList[i]);
+		mDelays[i] = -1;
+		mChannels[i] = NULL;
+	}
+	mDirect = 0;
+	for (int i = 0; i < numSensorDrivers; i++)
+		mConsumerLag[i] = 0;
+	for (int i = 0; i < MAX_DIRECT_CLIENTS; i++)
+		mDirectClients[i].fd = -1;
+
+	mStatsFd = openSocket(STATS_SOCKET_NAME, statsTag);
+	mDirectFd = openSocket(DIRECT_SOCKET_NAME, directTag);
+
+	// look for devices that were missing when the drivers were created
+	int inotifyFd = InputDeviceIndex::getInstance().getFd();
+	if (inotifyFd >= 0)
+		mReactor.addFd(inotifyFd, EPOLLIN, inputTag);
+}
 
-	mSensors[accelerometer] = new Accelerometer();
-	mPollFds[accelerometer].fd = mSensors[accelerometer]->getFd();
-	mPollFds[accelerometer].events = POLLIN;
-	mPollFds[accelerometer].revents = 0;
+sensors_poll_context_t::~sensors_poll_context_t() {
+	FUNC_LOG;
+	for (int i = 0; i < numSensorDrivers; i++)
+		releaseDriver(i);
+	for (int i = 0; i < numSensors; i++) {
+		delete mFifos[i];
+		delete mChannels[i];
+	}
+	for (int i = 0; i < MAX_DIRECT_CLIENTS; i++) {
+		if (mDirectClients[i].fd >= 0)
+			close(mDirectClients[i].fd);
+	}
+	pthread_mutex_destroy(&mLock);
+	pthread_mutex_destroy(&mDriverLock);
+	if (mStatsFd >= 0)
+		close(mStatsFd);
+	if (mDirectFd >= 0)
+		close(mDirectFd);
+}
 
-	mSensors[light] = new LightSensor();
-	mPollFds[light].fd = -1;
+void sensors_poll_context_t::wakeUp() {
+	mReactor.wake();
+}
 
-	mSensors[proximity] = new ProximitySensor();
-	mPollFds[proximity].fd = -1;
+/* listens on an abstract unix socket, watched by the reactor under tag */
+int sensors_poll_context_t::openSocket(const char* name, uint32_t tag) {
+	struct sockaddr_un addr;
+	socklen_t len;
 
-	mSensors[temperature] = new TemperatureMonitor();
-	mPollFds[temperature].fd = -1;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		ALOGE("error creating %s socket (%s)", name, strerror(errno));
+		return -1;
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	// abstract namespace: leading NUL, no file on disk
+	strcpy(addr.sun_path + 1, name);
+	len = offsetof(struct sockaddr_un, sun_path) + 1 + strlen(name);
+
+	if (bind(fd, (struct sockaddr*) &addr, len) < 0 || listen(fd, 1) < 0) {
+		ALOGE("error binding %s socket (%s)", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	mReactor.addFd(fd, EPOLLIN, tag);
+	return fd;
+}
 
-	int wakeFds[2];
-	int result = pipe(wakeFds);
-	ALOGE_IF(result < 0, "error creating wake pipe (%s)", strerror(errno));
-	fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
-	fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
-	mWritePipeFd = wakeFds[1];
+/* runs on the poll thread, which owns all counters but the drops */
+void sensors_poll_context_t::dumpStats() {
+	int fd = accept(mStatsFd, NULL, NULL);
+	if (fd < 0)
+		return;
+	mStats.dump(fd, sSensorList, numSensors);
+	close(fd);
+}
 
-	mPollFds[wake].fd = wakeFds[0];
-	mPollFds[wake].events = POLLIN;
-	mPollFds[wake].revents = 0;
+/*
+ * Takes a direct channel client in. Its request is read by
+ * readDirectClient() once the socket turns readable, so that nothing
+ * a client does holds the poll thread up.
+ */
+void sensors_poll_context_t::acceptDirectClient() {
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	int64_t now = now_ns();
+	int index = -1;
+
+	int fd = accept(mDirectFd, NULL, NULL);
+	if (fd < 0)
+		return;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0)
+		cred.uid = uid_t(-1);
+	if (cred.uid != 0 && cred.uid != getuid()) {
+		ALOGE("direct channel refused to uid %d", int(cred.uid));
+		close(fd);
+		return;
+	}
+
+	for (int i = 0; i < MAX_DIRECT_CLIENTS; i++) {
+		direct_client_t* client = &mDirectClients[i];
+		// a client which never sent its request is dropped for the next one
+		if (client->fd >= 0 && client->handle < 0 && client->deadline <= now)
+			closeDirectClient(i);
+		if (client->fd < 0 && index < 0)
+			index = i;
+	}
+	if (index < 0) {
+		int32_t status = -EBUSY;
+		send(fd, &status, sizeof(status), MSG_NOSIGNAL | MSG_DONTWAIT);
+		close(fd);
+		return;
+	}
+
+	direct_client_t* client = &mDirectClients[index];
+	pthread_mutex_lock(&mDriverLock);
+	client->fd = fd;
+	client->handle = -1;
+	client->deadline = now + DIRECT_REQUEST_TIMEOUT_NS;
+	pthread_mutex_unlock(&mDriverLock);
+	mReactor.addFd(fd, EPOLLIN, directClientTag + index);
 }
 
-sensors_poll_context_t::~sensors_poll_context_t() {
-	FUNC_LOG;
+/*
+ * Serves the request of a direct client: the sensor is kept running for
+ * as long as it stays connected, and the fd of its ring sent back with
+ * the status. Anything else from a client is it hanging up.
+ */
+void sensors_poll_context_t::readDirectClient(int index) {
+	direct_client_t* client = &mDirectClients[index];
+	struct direct_channel_request_t request;
+	int32_t status = 0;
+
+	if (client->handle >= 0) {
+		closeDirectClient(index);
+		return;
+	}
+	// the request is a single small write, it comes in whole or not at all
+	ssize_t n = recv(client->fd, &request, sizeof(request), MSG_DONTWAIT);
+	if (n < 0 && errno == EAGAIN) {
+		// the event was for the client this slot had before
+		return;
+	} else if (n != sizeof(request)) {
+		status = -EINVAL;
+	} else if (handleToDriver(request.handle) < 0 || request.period_ns < 0
+			|| sSensorList[request.handle].minDelay <= 0) {
+		// only continuous sensors stream into a ring
+		status = -EINVAL;
+	} else {
+		// no faster than the sensor can go
+		int64_t minPeriod = sSensorList[request.handle].minDelay * 1000LL;
+		pthread_mutex_lock(&mDriverLock);
+		client->handle = request.handle;
+		client->period = request.period_ns < minPeriod ?
+				minPeriod : request.period_ns;
+		pthread_mutex_unlock(&mDriverLock);
+		status = openDirect(request.handle);
+		if (status < 0) {
+			pthread_mutex_lock(&mDriverLock);
+			client->handle = -1;
+			pthread_mutex_unlock(&mDriverLock);
+		}
+	}
+
+	// the status goes with the ring fd, or alone if there is none
+	struct msghdr msg;
+	struct iovec iov = { &status, sizeof(status) };
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	if (!status) {
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		int ringFd = mChannels[request.handle]->getFd();
+		memcpy(CMSG_DATA(cmsg), &ringFd, sizeof(int));
+	}
+	// its hanging up is what tells that the channel is no longer needed
+	if (sendmsg(client->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) < 0 || status)
+		closeDirectClient(index);
+}
+
+void sensors_poll_context_t::closeDirectClient(int index) {
+	direct_client_t* client = &mDirectClients[index];
+
+	mReactor.removeFd(client->fd);
+	close(client->fd);
+	pthread_mutex_lock(&mDriverLock);
+	client->fd = -1;
+	pthread_mutex_unlock(&mDriverLock);
+	if (client->handle >= 0)
+		closeDirect(client->handle);
+}
+
+/*
+ * Sets up the ring of a handle unless it has one, and runs the sensor
+ * at the fastest rate of its framework and direct clients. The ring is
+ * shared, so every client gets that fastest rate.
+ */
+int sensors_poll_context_t::openDirect(int handle) {
+	int index = handleToDriver(handle);
+	int err = 0;
+
+	pthread_mutex_lock(&mDriverLock);
+	if (!mChannels[handle]) {
+		DirectChannel* channel = new DirectChannel();
+		err = channel->init(handle, DIRECT_CHANNEL_EVENTS);
+		SensorBase* sensor = err ? NULL : acquireDriver(index);
+		pthread_mutex_lock(&mLock);
+		bool enabled = mEnabled & (1 << handle);
+		pthread_mutex_unlock(&mLock);
+		if (sensor && !enabled) {
+			mThreads[index]->lock();
+			err = sensor->enable(handle, 1);
+			mThreads[index]->unlock();
+			mThreads[index]->update();
+		}
+		if (err) {
+			delete channel;
+			pthread_mutex_unlock(&mDriverLock);
+			return err;
+		}
+		mChannels[handle] = channel;
+		mThreads[index]->setChannel(handle, channel);
+		mDirect |= 1 << handle;
+	}
+	applyDelay(handle);
+	pthread_mutex_unlock(&mDriverLock);
+	return 0;
+}
+
+/*
+ * drops the ring of a handle once its last direct client is gone, or
+ * slows it down to the clients left
+ */
+void sensors_poll_context_t::closeDirect(int handle) {
+	int index = handleToDriver(handle);
+
+	pthread_mutex_lock(&mDriverLock);
+	for (int i = 0; i < MAX_DIRECT_CLIENTS; i++) {
+		if (mDirectClients[i].fd >= 0 && mDirectClients[i].handle == handle) {
+			// the client which left may have been the fastest one
+			applyDelay(handle);
+			pthread_mutex_unlock(&mDriverLock);
+			return;
+		}
+	}
+
+	mThreads[index]->setChannel(handle, NULL);
+	delete mChannels[handle];
+	mChannels[handle] = NULL;
+	mDirect &= ~(1 << handle);
+
+	pthread_mutex_lock(&mLock);
+	uint32_t enabled = mEnabled;
+	pthread_mutex_unlock(&mLock);
+	if (!(enabled & (1 << handle))) {
+		mThreads[index]->lock();
+		mSensors[index]->enable(handle, 0);
+		mThreads[index]->unlock();
+		mThreads[index]->update();
+	}
+	uint32_t users = 0;
+	for (int i = 0; i < numSensors; i++) {
+		if (sSensorDrivers[i] == index)
+			users |= (enabled | mDirect) & (1 << i);
+	}
+	if (!users)
+		releaseDriver(index);
+	else
+		applyDelay(handle);
+	pthread_mutex_unlock(&mDriverLock);
+}
+
+/* an input node came or went, let the reader threads reopen their device */
+void sensors_poll_context_t::handleHotplug() {
+	if (!InputDeviceIndex::getInstance().processEvents())
+		return;
+	pthread_mutex_lock(&mDriverLock);
 	for (int i = 0; i < numSensorDrivers; i++) {
-		delete mSensors[i];
+		if (mThreads[i])
+			mThreads[i]->hotplug();
+	}
+	pthread_mutex_unlock(&mDriverLock);
+}
+
+/*
+ * Creates the driver at index and starts its reader thread unless it is
+ * already running, then hands it the delays its sensors were given so
+ * far. Called with mDriverLock held.
+ */
+SensorBase* sensors_poll_context_t::acquireDriver(int index) {
+	if (mSensors[index])
+		return mSensors[index];
+
+	SensorBase* sensor = sDrivers[index].create();
+	for (int i = 0; i < numSensors; i++) {
+		if (sSensorDrivers[i] == index && mDelays[i] >= 0)
+			sensor->setDelay(i, mDelays[i]);
 	}
-	close(mPollFds[wake].fd);
-	close(mWritePipeFd);
+	mSensors[index] = sensor;
+	mThreads[index] = new SensorThread(sensor, &mQueue, &mReactor, &mStats,
+			&mConsumerLag[index]);
+	mThreads[index]->start();
+	return sensor;
+}
+
+/* stops the reader thread of a driver, then frees the driver */
+void sensors_poll_context_t::releaseDriver(int index) {
+	delete mThreads[index];
+	delete mSensors[index];
+	mThreads[index] = NULL;
+	mSensors[index] = NULL;
 }
 
 int sensors_poll_context_t::activate(int handle, int enabled) {
@@ -192,42 +576,91 @@ int sensors_poll_context_t::activate(int handle, int enabled) {
 	int index = handleToDriver(handle);
 	if (index < 0)
 		return index;
-	int err = mSensors[index]->enable(handle, enabled);
+
+	pthread_mutex_lock(&mDriverLock);
+	SensorBase* sensor = enabled ? acquireDriver(index) : mSensors[index];
+	if (!sensor) {
+		// never enabled, nothing to turn off
+		pthread_mutex_unlock(&mDriverLock);
+		return 0;
+	}
+	int err = 0;
+	// a direct channel keeps the sensor running whatever the framework does
+	if (!(mDirect & (1 << handle))) {
+		mThreads[index]->lock();
+		err = sensor->enable(handle, enabled);
+		mThreads[index]->unlock();
+		// the driver fd may have been opened or closed
+		mThreads[index]->update();
+	}
+
+	uint32_t users = 0;
+	pthread_mutex_lock(&mLock);
 	if (!err) {
-		int newState = enabled ? 1 : 0;
-		if (((uint32_t(newState) << index) != (mEnabled & (1 << index))) && ((1
-				<< index) != (1 << accelerometer))) {
-			mEnabled &= ~(1 << index);
-			mEnabled |= (uint32_t(newState) << index);
-			update_delay();
+		if (enabled) {
+			mEnabled |= 1 << handle;
+		} else {
+			mEnabled &= ~(1 << handle);
+			mFifos[handle]->clear();
 		}
 	}
-
-	if (enabled && !err) {
-		const char wakeMessage(WAKE_MESSAGE);
-		int result = write(mWritePipeFd, &wakeMessage, 1);
-		ALOGE_IF(result < 0, "error sending wake message (%s)", strerror(errno));
+	// whether or not enable() failed, the other sensors of the driver
+	// may still be using it
+	for (int i = 0; i < numSensors; i++) {
+		if (sSensorDrivers[i] == index)
+			users |= (mEnabled | mDirect) & (1 << i);
 	}
+	pthread_mutex_unlock(&mLock);
+
+	// give back the fds and buffers of a driver nobody uses any more
+	if (!users)
+		releaseDriver(index);
+	pthread_mutex_unlock(&mDriverLock);
+
+	if (enabled && !err)
+		wakeUp();
 	return err;
 }
 
-void sensors_poll_context_t::update_delay() {
-	uint64_t time = -1LLU;
+/* records the delay of a handle and passes it on if its driver exists */
+int sensors_poll_context_t::setDriverDelay(int handle, int64_t ns) {
+	pthread_mutex_lock(&mDriverLock);
+	int64_t old = mDelays[handle];
+	mDelays[handle] = ns;
+	int err = applyDelay(handle);
+	if (err)
+		mDelays[handle] = old;
+	pthread_mutex_unlock(&mDriverLock);
+	return err;
+}
 
-	if (mEnabled) {
-		for (int i = 0; i < numSensorDrivers; i++) {
-			if (mEnabled & (1 << i)) {
-				uint64_t temp = (uint64_t) mSensors[i]->getDelay();
-				time = time < temp ? time : temp;
-			}
-		}
+/*
+ * gives the driver of handle the shortest delay its framework and direct
+ * clients asked for; called with mDriverLock held
+ */
+int sensors_poll_context_t::applyDelay(int handle) {
+	SensorBase* sensor = mSensors[handleToDriver(handle)];
+	int64_t ns = mDelays[handle];
+
+	if (!sensor)
+		return 0;
+	for (int i = 0; i < MAX_DIRECT_CLIENTS; i++) {
+		direct_client_t const* client = &mDirectClients[i];
+		if (client->fd >= 0 && client->handle == handle
+				&& (ns < 0 || client->period < ns))
+			ns = client->period;
 	}
-	mTimeout = time;
+	if (ns < 0)
+		return 0;
+	SensorThread* thread = mThreads[handleToDriver(handle)];
+	thread->lock();
+	int err = sensor->setDelay(handle, ns);
+	thread->unlock();
+	return err;
 }
 
 int sensors_poll_context_t::setDelay(int handle, int64_t ns) {
 	FUNC_LOG;
-	int ret;
 	int index = handleToDriver(handle);
 
 	if (index < 0)
@@ -236,59 +669,218 @@ int sensors_poll_context_t::setDelay(int handle, int64_t ns) {
 	if (ns < 0)
 		return -EINVAL;
 
-	ret = mSensors[index]->setDelay(handle, ns);
-	if (ret >= 0)
-		update_delay();
-	return ret;
+	return setDriverDelay(handle, ns);
+}
+
+int sensors_poll_context_t::batch(int handle, int flags, int64_t period_ns,
+		int64_t timeout) {
+	FUNC_LOG;
+	int index = handleToDriver(handle);
+
+	if (index < 0)
+		return index;
+
+	if (period_ns < 0 || timeout < 0)
+		return -EINVAL;
+
+	// only sensors with an in-HAL FIFO can batch
+	if (timeout > 0 && !sSensorList[handle].fifoMaxEventCount)
+		return -EINVAL;
+
+	if (flags & SENSORS_BATCH_DRY_RUN)
+		return 0;
+
+	int err = setDriverDelay(handle, period_ns);
+	if (err < 0)
+		return err;
+
+	pthread_mutex_lock(&mLock);
+	mFifos[handle]->setTimeout(timeout);
+	pthread_mutex_unlock(&mLock);
+
+	// the poll thread has to pick up the new report latency
+	wakeUp();
+	return 0;
+}
+
+int sensors_poll_context_t::flush(int handle) {
+	FUNC_LOG;
+
+	if (handleToDriver(handle) < 0)
+		return -EINVAL;
+
+	// one-shot sensors have nothing to flush
+	if (sSensorList[handle].minDelay < 0)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mLock);
+	if (!(mEnabled & (1 << handle))) {
+		pthread_mutex_unlock(&mLock);
+		return -EINVAL;
+	}
+	mFifos[handle]->flush();
+	pthread_mutex_unlock(&mLock);
+
+	wakeUp();
+	return 0;
+}
+
+/*
+ * Moves the events of batching sensors out of data into their FIFO and
+ * returns how many events are left in data to be delivered right away.
+ * Also tells the drivers how long their continuous events waited.
+ */
+int sensors_poll_context_t::batchEvents(sensors_event_t* data,
+		int64_t const* queued, int count) {
+	int64_t now = now_ns();
+	int64_t lag[numSensorDrivers];
+	uint32_t unthrottled = 0;
+	int kept = 0;
+
+	for (int i = 0; i < numSensorDrivers; i++)
+		lag[i] = -1;
+
+	pthread_mutex_lock(&mLock);
+	for (int i = 0; i < count; i++) {
+		const int handle = data[i].sensor;
+		SensorFifo* fifo = mFifos[handle];
+		if (!(mEnabled & (1 << handle))) {
+			// running for a direct channel only, or just turned off
+			continue;
+		} else if (fifo->isBatching()) {
+			if (fifo->push(data[i], now))
+				mStats.recordDrop(handle, 1);
+		} else {
+			// how long it sat in the queue, not how old it is: decimated
+			// outputs are stamped half a group back from when they come
+			if (sSensorList[handle].minDelay > 0) {
+				const int driver = sSensorDrivers[handle];
+				if (now - queued[i] > lag[driver])
+					lag[driver] = now - queued[i];
+			}
+			if (kept != i)
+				data[kept] = data[i];
+			kept++;
+		}
+	}
+
+	// a consumer that batches or reads a direct channel lets events wait
+	// on purpose, mDirect only changes on this thread
+	for (int i = 0; i < numSensors; i++) {
+		if (((mEnabled & (1 << i)) && mFifos[i]->isBatching())
+				|| (mDirect & (1 << i)))
+			unthrottled |= 1 << sSensorDrivers[i];
+	}
+	pthread_mutex_unlock(&mLock);
+
+	for (int i = 0; i < numSensorDrivers; i++) {
+		if (unthrottled & (1 << i))
+			android_atomic_release_store(-1, &mConsumerLag[i]);
+		else if (lag[i] >= 0)
+			android_atomic_release_store(lag[i] / 1000 > INT_MAX ? INT_MAX
+					: int32_t(lag[i] / 1000), &mConsumerLag[i]);
+	}
+	return kept;
+}
+
+int sensors_poll_context_t::drainFifos(sensors_event_t* data, int count) {
+	int64_t now = now_ns();
+	int nbEvents = 0;
+
+	pthread_mutex_lock(&mLock);
+	for (int i = 0; count && i < numSensors; i++) {
+		int nb = mFifos[i]->drain(data, count, now);
+		count -= nb;
+		nbEvents += nb;
+		data += nb;
+	}
+	pthread_mutex_unlock(&mLock);
+	return nbEvents;
+}
+
+/* milliseconds until the first batch is due, -1 if none is pending */
+int sensors_poll_context_t::pollTimeout() {
+	int64_t now = now_ns();
+	int64_t first = -1;
+
+	pthread_mutex_lock(&mLock);
+	for (int i = 0; i < numSensors; i++) {
+		int64_t deadline = mFifos[i]->getDeadline();
+		if (deadline >= 0 && (first < 0 || deadline < first))
+			first = deadline;
+	}
+	pthread_mutex_unlock(&mLock);
+
+	if (first < 0)
+		return -1;
+	if (first <= now)
+		return 0;
+	return (int) ((first - now + 999999) / 1000000);
 }
 
 int sensors_poll_context_t::pollEvents(sensors_event_t* data, int count) {
 	FUNC_LOG;
+	sensors_event_t* const first = data;
 	int nbEvents = 0;
-	int readCount = 0;
 	int n = 0;
-	sensors_event_t* p = data;
 
 	do {
-		// see if we have some leftover from the last poll()
-		readCount = count > numSensorDrivers ? count / numSensorDrivers : 1;
-		for (int i = 0; count && i < numSensorDrivers; i++) {
-			SensorBase* const sensor(mSensors[i]);
-			if (sensor->hasPendingEvents() || (mPollFds[i].revents & POLLIN)) {
-				int nb = sensor->readEvents(data, readCount);
-				if (nb < count) {
-					// no more data for this sensor
-					mPollFds[i].revents = 0;
-				}
-				count -= nb;
-				nbEvents += nb;
-				data += nb;
-			}
+		// take what the reader threads have queued since the last call
+		// the queue never holds more than EVENT_QUEUE_SIZE events
+		int nb = batchEvents(data, mQueued, mQueue.read(data,
+				count < EVENT_QUEUE_SIZE ? count : EVENT_QUEUE_SIZE, mQueued));
+		count -= nb;
+		nbEvents += nb;
+		data += nb;
+
+		// hand out the batches whose report latency has expired
+		if (count > 0) {
+			nb = drainFifos(data, count);
+			count -= nb;
+			nbEvents += nb;
+			data += nb;
 		}
 
 		if (count > 0) {
 			// we still have some room, so try to see if we can get
-			// some events immediately or just wait if we don't have
-			// anything to return
-			int delay = (mTimeout == -1LLU) ? -1 : (int) (mTimeout / 1000000);
-			n = poll(mPollFds, numFds, nbEvents ? 0 : delay);
+			// some events immediately or just wait until a reader
+			// thread queues some or a batch deadline fires
+			struct epoll_event events[4];
+			n = mReactor.wait(events, ARRAY_SIZE(events),
+					nbEvents ? 0 : pollTimeout());
 			if (n < 0) {
-				ALOGE("poll() failed (%s)", strerror(errno));
-				return -errno;
+				ALOGE("epoll_wait() failed (%s)", strerror(-n));
+				return n;
 			}
-			if (mPollFds[wake].revents & POLLIN) {
-				char msg;
-				int result = read(mPollFds[wake].fd, &msg, 1);
-				ALOGE_IF(result < 0, "error reading from wake pipe (%s)",
-						strerror(errno));
-				ALOGE_IF(msg != WAKE_MESSAGE,
-						"unknown message on wake queue (0x%02x) %c", int(msg),
-						msg);
-				mPollFds[wake].revents = 0;
+			mStats.recordPoll(n > 0);
+			for (int i = 0; i < n; i++) {
+				if (events[i].data.u32 == statsTag)
+					dumpStats();
+				else if (events[i].data.u32 == inputTag)
+					handleHotplug();
+				else if (events[i].data.u32 == directTag)
+					acceptDirectClient();
+				else if (events[i].data.u32 >= directClientTag
+						&& events[i].data.u32 != SensorReactor::WAKE) {
+					int index = events[i].data.u32 - directClientTag;
+					// unless acceptDirectClient() closed it in this batch
+					if (mDirectClients[index].fd >= 0)
+						readDirectClient(index);
+				}
 			}
 		}
-		// if we have events and space, go read them
-	} while (n > 0 && count > 0);
+		// if we have events and space, go read them; a timeout with
+		// nothing delivered yet means a batch has become due
+	} while ((n > 0 || !nbEvents) && count > 0);
+
+	// one-shot sensors turn themselves off once they have triggered
+	for (int i = 0; i < nbEvents; i++) {
+		if (first[i].type != SENSOR_TYPE_META_DATA
+				&& sSensorList[first[i].sensor].minDelay < 0)
+			activate(first[i].sensor, 0);
+	}
+
+	mStats.recordDelivery(first, nbEvents);
 	return nbEvents;
 }
 
@@ -318,6 +910,19 @@ static int poll__setDelay(struct sensors_poll_device_t *dev, int handle,
 	return ctx->setDelay(handle, ns);
 }
 
+static int poll__batch(struct sensors_poll_device_1 *dev, int handle,
+		int flags, int64_t period_ns, int64_t timeout) {
+	FUNC_LOG;
+	sensors_poll_context_t *ctx = (sensors_poll_context_t *) dev;
+	return ctx->batch(handle, flags, period_ns, timeout);
+}
+
+static int poll__flush(struct sensors_poll_device_1 *dev, int handle) {
+	FUNC_LOG;
+	sensors_poll_context_t *ctx = (sensors_poll_context_t *) dev;
+	return ctx->flush(handle);
+}
+
 static int poll__poll(struct sensors_poll_device_t *dev, sensors_event_t* data,
 		int count) {
 	FUNC_LOG;
@@ -334,15 +939,17 @@ static int open_sensors(const struct hw_module_t* module, const char* id,
 	int status = -EINVAL;
 	sensors_poll_context_t *dev = new sensors_poll_context_t();
 
-	memset(&dev->device, 0, sizeof(sensors_poll_device_t));
+	memset(&dev->device, 0, sizeof(sensors_poll_device_1));
 
 	dev->device.common.tag = HARDWARE_DEVICE_TAG;
-	dev->device.common.version = 0;
+	dev->device.common.version = SENSORS_DEVICE_API_VERSION_1_1;
 	dev->device.common.module = const_cast<hw_module_t*> (module);
 	dev->device.common.close = poll__close;
 	dev->device.activate = poll__activate;
 	dev->device.setDelay = poll__setDelay;
 	dev->device.poll = poll__poll;
+	dev->device.batch = poll__batch;
+	dev->device.flush = poll__flush;
 
 	*device = &dev->device.common;
 	status = 0;
@@ -33,10 +33,87 @@ __BEGIN_DECLS
 
 #define ARRAY_SIZE(a)			(sizeof(a) / sizeof(a[0]))
 
-#define ID_A  (0)
-#define ID_L  (1)
-#define ID_P  (2)
-#define ID_T  (3)
+/* prefix of all sysfs paths, the host benchmark points it at a scratch tree */
+#ifndef SYSFS_ROOT
+#define SYSFS_ROOT				""
+#endif
+
+/* prefix of the files the HAL keeps its state in across boots, likewise */
+#ifndef DATA_ROOT
+#define DATA_ROOT				""
+#endif
+
+/*
+ * Registry of the drivers and of the sensors they serve, one entry each:
+ *
+ *   SENSOR_DRIVER(id, driverClass)
+ *   SENSOR(id, driver, output, name, vendor, type, maxRange, resolution,
+ *          power, minDelay, fifoReservedEventCount, fifoMaxEventCount)
+ *
+ * A driver is DRIVER_<id>. A sensor gets ID_<id> as its handle, in the
+ * order of SENSOR_LIST; driver is the id of the driver serving it and
+ * output which of that driver's outputs it is, for drivers with several.
+ * The handles, the sensor list and the handle to driver map all follow
+ * from these lists, so supporting a new sensor takes one SENSOR entry,
+ * plus a SENSOR_DRIVER entry if it comes with a driver of its own.
+ */
+#define SENSOR_DRIVER_LIST(SENSOR_DRIVER) \
+	SENSOR_DRIVER(ACCELEROMETER, Accelerometer) \
+	SENSOR_DRIVER(LIGHT, LightSensor) \
+	SENSOR_DRIVER(PROXIMITY, ProximitySensor) \
+	SENSOR_DRIVER(TEMPERATURE, TemperatureMonitor)
+
+#define SENSOR_LIST(SENSOR) \
+	SENSOR(A, ACCELEROMETER, accel, \
+			"3-axis Accelerometer", "Analog Devices", \
+			SENSOR_TYPE_ACCELEROMETER, RANGE_A, RESOLUTION_A, 0.23f, 20000, \
+			PACKED_RESERVED_EVENTS(FIFO_BYTES_A), \
+			PACKED_MAX_EVENTS(FIFO_BYTES_A)) \
+	SENSOR(L, LIGHT, 0, \
+			"Intersil isl29018 Ambient Light Sensor", "Intersil", \
+			SENSOR_TYPE_LIGHT, 1000.0f, 1.0f, 1.0f, 0, \
+			FIFO_MAX_EVENTS_L, FIFO_MAX_EVENTS_L) \
+	SENSOR(P, PROXIMITY, 0, \
+			"Intersil isl29018 Proximity sensor", "Intersil", \
+			SENSOR_TYPE_PROXIMITY, 1.0f, 1.0f, 1.0f, 0, 0, 0) \
+	SENSOR(T, TEMPERATURE, 0, \
+			"ADT7461 Temperature Monitor", "Analog Devices", \
+			SENSOR_TYPE_TEMPERATURE, 150.0f, 1.0f, 1.0f, 0, 0, 0) \
+	SENSOR(G, ACCELEROMETER, gravity, \
+			"Gravity Sensor", "AOSP", \
+			SENSOR_TYPE_GRAVITY, RANGE_A, RESOLUTION_A, 0.23f, 20000, 0, 0) \
+	SENSOR(LA, ACCELEROMETER, linear, \
+			"Linear Acceleration Sensor", "AOSP", \
+			SENSOR_TYPE_LINEAR_ACCELERATION, RANGE_A, RESOLUTION_A, 0.23f, \
+			20000, 0, 0) \
+	SENSOR(O, ACCELEROMETER, orientation, \
+			"Orientation Sensor", "AOSP", \
+			SENSOR_TYPE_ORIENTATION, 360.0f, 0.1f, 0.23f, 20000, 0, 0) \
+	SENSOR(SD, ACCELEROMETER, stepDetector, \
+			"Step Detector", "AOSP", \
+			SENSOR_TYPE_STEP_DETECTOR, 1.0f, 1.0f, 0.23f, 0, 0, 0) \
+	SENSOR(SC, ACCELEROMETER, stepCounter, \
+			"Step Counter", "AOSP", \
+			SENSOR_TYPE_STEP_COUNTER, 4294967295.0f, 1.0f, 0.23f, 0, 0, 0) \
+	/* a minimum delay of -1 makes it one-shot */ \
+	SENSOR(SM, ACCELEROMETER, significantMotion, \
+			"Significant Motion Detector", "AOSP", \
+			SENSOR_TYPE_SIGNIFICANT_MOTION, 1.0f, 1.0f, 0.23f, -1, 0, 0)
+
+#define SENSOR_DRIVER_ID(id, driverClass)	DRIVER_##id,
+enum {
+	SENSOR_DRIVER_LIST(SENSOR_DRIVER_ID)
+	numSensorDrivers
+};
+#undef SENSOR_DRIVER_ID
+
+#define SENSOR_ID(id, driver, output, name, vendor, type, maxRange, \
+		resolution, power, minDelay, fifoReserved, fifoMax)	ID_##id,
+enum {
+	SENSOR_LIST(SENSOR_ID)
+	numSensors
+};
+#undef SENSOR_ID
 
 /*****************************************************************************/
 
@@ -44,6 +121,14 @@ __BEGIN_DECLS
 #define RANGE_A					(2 * GRAVITY_EARTH)
 #define RESOLUTION_A			(RANGE_A / (4096 / 2))
 
+// events the HAL can hold for a batching light client
+#define FIFO_MAX_EVENTS_L		(256)
+/*
+ * the accelerometer batch is packed into what 1024 whole events took, see
+ * PackedSensorFifo.h for how many it is sure to hold and can hold at most
+ */
+#define FIFO_BYTES_A			(1024 * sizeof(sensors_event_t))
+
 /*****************************************************************************/
 
 __END_DECLS